@@ -23,10 +23,18 @@
 
 #include <inttypes.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
 #include <mutex>
 #include <queue>
 #include <string>
+#include <thread>
+#include <tuple>
 #include <unordered_map>
+#include <vector>
 
 #include "imgui.h"
 
@@ -39,423 +47,3272 @@ namespace imlottie {
     std::shared_ptr<imlottie::Animation> animationLoad(const char *path);
     uint16_t animationTotalFrame(const std::shared_ptr<imlottie::Animation> &anim);
     double animationDuration(const std::shared_ptr<imlottie::Animation> &anim);
-    void animationRenderSync(const std::shared_ptr<imlottie::Animation> &anim, int nextFrameIndex, uint32_t *data, int width, int height, int row_pitch);
+    // name, start and end frame of markers set in After Effects
+    const std::vector<std::tuple<std::string, int, int>> &animationMarkers(const std::shared_ptr<imlottie::Animation> &anim);
+    // returns false when frame is same as last rendered one, with skipUnchanged data is not touched then.
+    // damage (can be null) gets x, y, width, height of area changed since last rendered frame
+    bool animationRenderSync(const std::shared_ptr<imlottie::Animation> &anim, int nextFrameIndex, uint32_t *data, int width, int height, int row_pitch, bool skipUnchanged, int *damage);
 }
 
 namespace ImLottie {
 
 constexpr ImGuiID BAD_PICTUREID = ImGuiID(-1);
 
+// Area of frame in pixels, x1 and y1 not included
+struct LottieRect {
+    int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+
+    static LottieRect sized(int x, int y, int w, int h) {
+        LottieRect rect;
+        rect.x0 = x;
+        rect.y0 = y;
+        rect.x1 = x + w;
+        rect.y1 = y + h;
+        return rect;
+    }
+
+    bool empty() const { return x1 <= x0 || y1 <= y0; }
+    int width() const { return x1 - x0; }
+    int height() const { return y1 - y0; }
+
+    void add(const LottieRect &r) {
+        if (r.empty()) {
+            return;
+        }
+        if (empty()) {
+            *this = r;
+            return;
+        }
+        x0 = std::min(x0, r.x0);
+        y0 = std::min(y0, r.y0);
+        x1 = std::max(x1, r.x1);
+        y1 = std::max(y1, r.y1);
+    }
+
+    void clip(int w, int h) {
+        x0 = std::max(x0, 0);
+        y0 = std::max(y0, 0);
+        x1 = std::min(x1, w);
+        y1 = std::min(y1, h);
+    }
+};
+
+// Pixels of one frame, memory is own or lent by texture backend. Lent memory is mapped
+// upload memory, renderer draws there directly and backend copies it to texture without
+// extra copy on cpu. Rows of lent memory can be longer than frame row
+struct LottieFrameBuffer {
+    std::vector<uint8_t> owned;
+    uint8_t *pixels = nullptr;
+    int width = 0;
+    int height = 0;
+    int pitch = 0;
+    // backend handle of lent memory, null for own memory
+    void *lent = nullptr;
+
+    // pixels can point to owned memory, so buffer only moved and moved buffer stays empty
+    LottieFrameBuffer() = default;
+    LottieFrameBuffer(const LottieFrameBuffer &) = delete;
+    LottieFrameBuffer &operator=(const LottieFrameBuffer &) = delete;
+
+    LottieFrameBuffer(LottieFrameBuffer &&other) noexcept {
+        *this = std::move(other);
+    }
+
+    LottieFrameBuffer &operator=(LottieFrameBuffer &&other) noexcept {
+        if (this != &other) {
+            owned = std::move(other.owned);
+            pixels = other.pixels;
+            width = other.width;
+            height = other.height;
+            pitch = other.pitch;
+            lent = other.lent;
+            other.owned.clear();
+            other.pixels = nullptr;
+            other.width = other.height = other.pitch = 0;
+            other.lent = nullptr;
+        }
+        return *this;
+    }
+
+    bool empty() const { return pixels == nullptr; }
+    uint8_t *data() const { return pixels; }
+    size_t size() const { return (size_t)width * height * 4; }
+
+    // copy frame with packed rows to buffer
+    void write(const uint8_t *src) {
+        const size_t row = (size_t)width * 4;
+        for (int y = 0; y < height; ++y) {
+            memcpy(pixels + (size_t)y * pitch, src + y * row, row);
+        }
+    }
+
+    // copy buffer to frame with packed rows
+    void read(std::vector<uint8_t> &dst) const {
+        const size_t row = (size_t)width * 4;
+        dst.resize(size());
+        for (int y = 0; y < height; ++y) {
+            memcpy(dst.data() + y * row, pixels + (size_t)y * pitch, row);
+        }
+    }
+};
+
 // Data in system memory where saved frame
 struct NextFrame {
-    std::vector<uint8_t> data;
+    LottieFrameBuffer data;
+    ImVec2 size;
+    // number of frame from timeline start, it not wrapped for looped animations
+    uint32_t serial = 0;
+    // frames with same version have same pixels, data is empty when frame same as previous one
+    uint32_t version = 0;
+};
+
+// Data in system memory, this frame ready for move to tmp atlas
+struct ReadyFrame {
+    ImGuiID pid = BAD_PICTUREID;
+    LottieFrameBuffer data;
     ImVec2 size;
+    uint32_t version = 0;
+    // pixels differ from frame with baseVersion only in damage area, texture with that
+    // frame is updated only there
+    uint32_t baseVersion = 0;
+    LottieRect damage;
+};
+
+// Pool of pixel buffers, render thread take buffer for every prerendered frame and main
+// thread return it back after upload to texture, so playback not allocate memory per frame.
+// Buffers grouped by byte size, because every animation can have own canvas size.
+// Buffers lent by backend are taken first, main thread lends as many as frames wanted
+struct LottieFramePool {
+    // how many free buffers of one size pool can keep, extra buffers will be freed
+    static constexpr size_t MAX_FREE_BUFFERS = 64;
+    // how many lent buffers of one size pool can keep, not used memory goes back to backend
+    static constexpr int MAX_LENT_BUFFERS = 8;
+
+    std::mutex mutex;
+    std::unordered_map<size_t, std::vector<LottieFrameBuffer>> buckets;
+    // lent buffers by frame size, how many frames of size got own memory since last lend
+    std::unordered_map<uint64_t, std::vector<LottieFrameBuffer>> lentBuckets;
+    std::unordered_map<uint64_t, int> lentWanted;
+    // lent buffers which pool not need, main thread gives them back to backend
+    std::vector<LottieFrameBuffer> reclaimed;
+    // how many buffers were allocated because pool has not free one
+    std::atomic<uint64_t> allocations{0};
+    // bytes of all buffers created by pool, free and used by frames
+    std::atomic<size_t> liveBytes{0};
+
+    static uint64_t sizeKey(int width, int height) {
+        return ((uint64_t)(uint32_t)width << 32) | (uint32_t)height;
+    }
+
+    void acquire(int width, int height, LottieFrameBuffer &buffer) {
+        release(buffer);
+        const size_t bytes = (size_t)width * height * 4;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            const uint64_t key = sizeKey(width, height);
+            auto lent = lentBuckets.find(key);
+            if (lent != lentBuckets.end() && !lent->second.empty()) {
+                std::swap(buffer, lent->second.back());
+                lent->second.pop_back();
+                return;
+            }
+            lentWanted[key]++;
+
+            auto &bucket = buckets[bytes];
+            if (!bucket.empty()) {
+                std::swap(buffer, bucket.back());
+                bucket.pop_back();
+                buffer.width = width;
+                buffer.height = height;
+                buffer.pitch = width * 4;
+                return;
+            }
+        }
+
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        liveBytes.fetch_add(bytes, std::memory_order_relaxed);
+        buffer.owned.resize(bytes);
+        buffer.pixels = buffer.owned.data();
+        buffer.width = width;
+        buffer.height = height;
+        buffer.pitch = width * 4;
+    }
+
+    void release(LottieFrameBuffer &buffer) {
+        if (buffer.empty()) {
+            return;
+        }
+
+        LottieFrameBuffer freed;
+        std::swap(freed, buffer);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        // lent memory still mapped, next frame of same size can be rendered there
+        if (freed.lent) {
+            auto &bucket = lentBuckets[sizeKey(freed.width, freed.height)];
+            if ((int)bucket.size() < MAX_LENT_BUFFERS) {
+                bucket.push_back(std::move(freed));
+            } else {
+                reclaimed.push_back(std::move(freed));
+            }
+            return;
+        }
+
+        auto &bucket = buckets[freed.size()];
+        if (bucket.size() < MAX_FREE_BUFFERS) {
+            if (bucket.capacity() == 0) {
+                bucket.reserve(MAX_FREE_BUFFERS);
+            }
+            bucket.push_back(std::move(freed));
+        } else {
+            liveBytes.fetch_sub(freed.size(), std::memory_order_relaxed);
+        }
+    }
+
+    // free all buffers which not used now
+    void trim() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto &it : buckets) {
+            for (const LottieFrameBuffer &buffer : it.second) {
+                liveBytes.fetch_sub(buffer.size(), std::memory_order_relaxed);
+            }
+            it.second.clear();
+        }
+        for (auto &it : lentBuckets) {
+            for (LottieFrameBuffer &buffer : it.second) {
+                reclaimed.push_back(std::move(buffer));
+            }
+            it.second.clear();
+        }
+    }
+};
+
+// Fixed size ring with queue interface, slots are reused and never reallocated after reset()
+template<typename T>
+struct LottieFixedRing {
+    std::vector<T> slots;
+    size_t head = 0;
+    size_t count = 0;
+
+    void reset(size_t capacity) {
+        slots.clear();
+        slots.resize(capacity);
+        head = count = 0;
+    }
+
+    size_t size() const { return count; }
+    size_t capacity() const { return slots.size(); }
+    T &front() { return slots[head]; }
+    T &back() { return slots[(head + count - 1) % slots.size()]; }
+    const T &front() const { return slots[head]; }
+    const T &back() const { return slots[(head + count - 1) % slots.size()]; }
+
+    // returns new last slot, it keep content of previous usage
+    T &push() {
+        assert(count < slots.size());
+        count++;
+        return back();
+    }
+
+    void pop() {
+        head = (head + 1) % slots.size();
+        count--;
+    }
+};
+
+// Lock-free triple buffer for one producer and one consumer, newest published value wins.
+// Producer fills back() and publish() swaps it with middle slot, consumer take() swaps
+// middle with front() when it holds value not taken yet. Slots are swapped by index only,
+// so content of replaced value stays in back() after publish() and producer reuse it
+template<typename T>
+struct LottieTripleBuffer {
+    static constexpr uint8_t INDEX_MASK = 3;
+    static constexpr uint8_t DIRTY = 4;
+
+    T slots[3];
+    std::atomic<uint8_t> middle{1};
+    uint8_t backIndex = 0;  // producer side
+    uint8_t frontIndex = 2; // consumer side
+
+    T &back() { return slots[backIndex]; }
+    T &front() { return slots[frontIndex]; }
+
+    // returns true when previous value was not taken and now it is in back()
+    bool publish() {
+        const uint8_t prev = middle.exchange(backIndex | DIRTY, std::memory_order_acq_rel);
+        backIndex = prev & INDEX_MASK;
+        return (prev & DIRTY) != 0;
+    }
+
+    // published value not taken yet, it can be taken by consumer at any moment
+    bool pending() const {
+        return (middle.load(std::memory_order_acquire) & DIRTY) != 0;
+    }
+
+    // returns false when nothing new was published since last take
+    bool take() {
+        if (!pending()) {
+            return false;
+        }
+
+        const uint8_t prev = middle.exchange(frontIndex, std::memory_order_acq_rel);
+        frontIndex = prev & INDEX_MASK;
+        return true;
+    }
+};
+
+// Newest frame of one animation waiting for upload, created by main thread for every
+// animation and shared with render thread, frames of animations never replace each other
+using LottieReadyFrames = LottieTripleBuffer<ReadyFrame>;
+
+// Named part of timeline set in After Effects, frames first..last are played by playMarker
+struct LottieMarker {
+    std::string name;
+    int first = 0;
+    int last = 0;
+};
+
+// Reads and parses animation files on own threads, so playing animations not wait while
+// big file loaded. Render thread post jobs and take results on its tick
+struct LottieLoader {
+    static constexpr int DEFAULT_THREADS = 2;
+
+    struct Job {
+        ImGuiID key = 0;
+        uint32_t ticket = 0;
+        std::string path;
+    };
+
+    struct Result {
+        ImGuiID key = 0;
+        uint32_t ticket = 0;
+        std::shared_ptr<imlottie::Animation> anim;
+        uint16_t total = 0;
+        double duration = 0;
+        size_t fileBytes = 0;
+        std::vector<LottieMarker> markers;
+    };
+
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable jobReady;
+    std::queue<Job> jobs;
+    std::vector<Result> results;
+    std::atomic<size_t> resultsCount{0};
+    bool terminating = false;
+    // jobs parsed now, guarded by mutex
+    int busy = 0;
+
+    // called from loader thread when result ready
+    void (*onLoaded)(void *ctx) = nullptr;
+    void *onLoadedCtx = nullptr;
+
+    static size_t fileBytes(const char *path) {
+        FILE *f = fopen(path, "rb");
+        if (!f) {
+            return 0;
+        }
+        fseek(f, 0, SEEK_END);
+        const long size = ftell(f);
+        fclose(f);
+        return size > 0 ? (size_t)size : 0;
+    }
+
+    void start(int count) {
+        for (int i = 0; i < count; ++i) {
+            threads.emplace_back([this] () { loaderLoop(); });
+        }
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            terminating = true;
+        }
+        jobReady.notify_all();
+        for (auto &t : threads) {
+            t.join();
+        }
+        threads.clear();
+    }
+
+    void post(Job &&job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push(std::move(job));
+        }
+        jobReady.notify_one();
+    }
+
+    bool hasResults() const {
+        return resultsCount.load(std::memory_order_acquire) > 0;
+    }
+
+    // nothing parsed or waiting in queue, and all results taken
+    bool idle() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return jobs.empty() && busy == 0 && results.empty();
+    }
+
+    void takeResults(std::vector<Result> &out) {
+        out.clear();
+        std::lock_guard<std::mutex> lock(mutex);
+        std::swap(out, results);
+        resultsCount.store(0, std::memory_order_release);
+    }
+
+    void loaderLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            jobReady.wait(lock, [this] () { return terminating || !jobs.empty(); });
+            if (terminating) {
+                return;
+            }
+
+            Job job = std::move(jobs.front());
+            jobs.pop();
+            busy++;
+            lock.unlock();
+
+            // parse and build item tree without lock, it is the longest part
+            Result result;
+            result.key = job.key;
+            result.ticket = job.ticket;
+            result.anim = imlottie::animationLoad(job.path.c_str());
+            if (result.anim) {
+                result.total = (uint16_t)imlottie::animationTotalFrame(result.anim);
+                result.duration = imlottie::animationDuration(result.anim);
+                result.fileBytes = fileBytes(job.path.c_str());
+                for (const auto &m : imlottie::animationMarkers(result.anim)) {
+                    result.markers.push_back({std::get<0>(m), std::get<1>(m), std::get<2>(m)});
+                }
+            } else {
+                printf("Lottie::animation load failed from <%s>", job.path.c_str());
+            }
+
+            lock.lock();
+            busy--;
+            results.push_back(std::move(result));
+            resultsCount.store(results.size(), std::memory_order_release);
+            lock.unlock();
+
+            if (onLoaded) {
+                onLoaded(onLoadedCtx);
+            }
+            lock.lock();
+        }
+    }
+};
+
+// Parsed animation and last rendered frames, shared by all animations with same file, canvas size and rate.
+// Loop flag is not part of key, so looped and once played copies of icon share frames too. Every frame
+// index rasterized once and copied to other instances, they show same index at same time because
+// timelines aligned to epoch of source
+struct LottieFrameSource {
+    // how many last rendered frames kept for other instances
+    static constexpr int CACHED_FRAMES = 4;
+
+    ImGuiID key = 0;
+    int refs = 0;
+    int rate = 0;
+    // size requested by widgets, frames can be rendered smaller when quality reduced
+    int fullWidth = 0;
+    int fullHeight = 0;
+    int width = 0;
+    int height = 0;
+    uint16_t total = 0;
+    uint32_t duration_ms = 0;
+    // time of frame 0 for all instances
+    uint64_t epoch_ms = 0;
+    std::shared_ptr<imlottie::Animation> anim;
+    // model can be unloaded by memory budget, it loaded again when needed
+    std::string path;
+    // model is parsed by loader, ticket of last posted job
+    bool loading = false;
+    bool failed = false;
+    uint32_t loadTicket = 0;
+    // parser not report its allocations, model size estimated by file size
+    static constexpr size_t MODEL_BYTES_PER_FILE_BYTE = 4;
+    size_t modelBytes = 0;
+    // when any instance shown frame last time, least recently shown sources evicted first
+    std::atomic<uint64_t> lastShown_ms{0};
+    std::vector<LottieMarker> markers;
+
+    struct CachedFrame {
+        int index = -1;
+        std::vector<uint8_t> data;
+    };
+    CachedFrame cached[CACHED_FRAMES];
+    int nextCached = 0;
+
+    // small animations rendered once to contiguous store, every frame after that is copy only
+    std::vector<uint8_t> baked;
+    std::vector<uint8_t> bakedFrames;
+    size_t bakedCount = 0;
+    int bakeFirst = 0;
+    // store was evicted by memory budget, not bake again
+    bool bakeEvicted = false;
+
+    // frames with same version have same pixels, renderer tells when frame not changed since
+    // last rendered one. Version of every rendered index kept, so held frames are not rendered again
+    static constexpr uint32_t NO_VERSION = 0;
+    uint32_t version = NO_VERSION;
+    std::vector<uint32_t> frameVersions;
+
+    // area changed by every of last versions, texture with older version updates only their union
+    static constexpr uint32_t DAMAGE_HISTORY = 32;
+    LottieRect damages[DAMAGE_HISTORY];
+
+    // instances rendered on different workers, but animation keep scene state inside
+    std::mutex renderMutex;
+
+    static ImGuiID getKey(const char *lottie, const int canvasWidth, const int canvasHeight, int rate) {
+        const int props[] = { canvasWidth, canvasHeight, rate };
+        return ImHashData(props, sizeof(props), ImHashStr(lottie, 0, 0xc001f00d));
+    }
+
+    size_t frameBytes() const {
+        return (size_t)width * height * sizeof(uint32_t);
+    }
+
+    void init(ImGuiID _key, const char *_path, int w, int h, int _rate) {
+        key = _key;
+        path = _path;
+        fullWidth = width = w;
+        fullHeight = height = h;
+        rate = _rate;
+    }
+
+    // render frames with lower resolution, they upscaled on draw. Baked frames cost only
+    // copy and they not rescaled
+    bool rescale(float scale) {
+        if (!ready() || !baked.empty()) {
+            return false;
+        }
+
+        const int w = std::max<int>(int(fullWidth * scale), 1);
+        const int h = std::max<int>(int(fullHeight * scale), 1);
+        if (w == width && h == height) {
+            return false;
+        }
+
+        width = w;
+        height = h;
+        clearCache();
+        std::fill(frameVersions.begin(), frameVersions.end(), NO_VERSION);
+        return true;
+    }
+
+    bool ready() const {
+        return anim != nullptr && total > 0 && duration_ms > 0;
+    }
+
+    // model parsed by loader, first time timeline created
+    void applyLoaded(LottieLoader::Result &result, uint64_t curTime) {
+        loading = false;
+        anim = std::move(result.anim);
+        if (!anim) {
+            failed = true;
+            return;
+        }
+
+        // offscreen layers of renderer take about one canvas
+        modelBytes = result.fileBytes * MODEL_BYTES_PER_FILE_BYTE + frameBytes();
+
+        // model reloaded after eviction, timeline stay the same
+        if (total > 0) {
+            return;
+        }
+
+        epoch_ms = curTime;
+        lastShown_ms.store(curTime, std::memory_order_relaxed);
+        total = result.total;
+        float oneFrameMs = total > 0 ? (float)result.duration / total : 0.f;
+        duration_ms = int(rate > 0 ? 1000 / rate : oneFrameMs * 1000);
+        frameVersions.assign(total, NO_VERSION);
+        markers = std::move(result.markers);
+    }
+
+    // frames first..first+count-1 are played by instances, they baked when all fit to budget.
+    // Store created again when range changed, frames of other segments not kept
+    void setBakeRange(int first, int count, size_t bakeBudget) {
+        std::lock_guard<std::mutex> lock(renderMutex);
+        if (!baked.empty() && first == bakeFirst && count == (int)bakedFrames.size()) {
+            return;
+        }
+
+        baked = std::vector<uint8_t>();
+        bakedFrames = std::vector<uint8_t>();
+        bakedCount = 0;
+        bakeFirst = first;
+        // frames of reduced quality are not baked, store would keep them reduced
+        if (!bakeEvicted && count > 0 && width == fullWidth && height == fullHeight && frameBytes() * count <= bakeBudget) {
+            baked.resize(frameBytes() * count);
+            bakedFrames.assign(count, 0);
+        }
+    }
+
+    bool isBaked(int index) const {
+        return !baked.empty() && index >= bakeFirst && index < bakeFirst + (int)bakedFrames.size();
+    }
+
+    bool bakePending() const {
+        return !baked.empty() && bakedCount < bakedFrames.size();
+    }
+
+    // frame range of marker, false when animation has not such marker
+    bool findMarker(const std::string &name, int &first, int &last) const {
+        for (const LottieMarker &m : markers) {
+            if (m.name == name) {
+                first = m.first;
+                last = m.last;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // memory used by model and frames of source, render thread only
+    size_t memoryBytes() const {
+        size_t bytes = anim ? modelBytes : 0;
+        bytes += baked.capacity();
+        for (const CachedFrame &c : cached) {
+            bytes += c.data.capacity();
+        }
+        return bytes;
+    }
+
+    // free frames which can be rendered again
+    void evictFrames() {
+        clearCache();
+        if (!baked.empty()) {
+            baked = std::vector<uint8_t>();
+            bakedFrames = std::vector<uint8_t>();
+            bakedCount = 0;
+            bakeEvicted = true;
+        }
+    }
+
+    // free model, it loaded again when instance need render
+    void evictModel() {
+        evictFrames();
+        anim.reset();
+    }
+
+    // rasterize frame, new version is created when renderer drawn something different
+    void rasterize(int index, uint8_t *data, int pitch, bool skipUnchanged) {
+        int damage[4] = {};
+        if (imlottie::animationRenderSync(anim, index, (uint32_t *)data, width, height, pitch, skipUnchanged, damage)) {
+            version++;
+            damages[version % DAMAGE_HISTORY] = LottieRect::sized(damage[0], damage[1], damage[2], damage[3]);
+        }
+        frameVersions[index] = version;
+    }
+
+    // area where frames with versions from and to can differ, whole frame when history is lost
+    LottieRect damageSince(uint32_t from, uint32_t to) {
+        std::lock_guard<std::mutex> lock(renderMutex);
+        const uint32_t first = std::min(from, to);
+        const uint32_t last = std::max(from, to);
+        if (first == NO_VERSION || last - first >= DAMAGE_HISTORY) {
+            return LottieRect::sized(0, 0, width, height);
+        }
+
+        LottieRect rect;
+        for (uint32_t v = first + 1; v <= last; ++v) {
+            rect.add(damages[v % DAMAGE_HISTORY]);
+        }
+        return rect;
+    }
+
+    // renders frame to store when it not baked yet
+    uint8_t *bakeFrame(int index) {
+        const int slot = index - bakeFirst;
+        uint8_t *data = baked.data() + frameBytes() * slot;
+        if (!bakedFrames[slot]) {
+            rasterize(index, data, width * (int)sizeof(uint32_t), false);
+            bakedFrames[slot] = 1;
+            bakedCount++;
+        }
+        return data;
+    }
+
+    // bake one of frames which were not requested yet, called by render thread in free time
+    bool bakeNext() {
+        std::lock_guard<std::mutex> lock(renderMutex);
+        if (!bakePending() || !anim) {
+            return false;
+        }
+
+        auto it = std::find(bakedFrames.begin(), bakedFrames.end(), 0);
+        bakeFrame(bakeFirst + int(it - bakedFrames.begin()));
+        return true;
+    }
+
+    // nearest frame start on shared grid, not later than time
+    uint64_t alignedStart(uint64_t time) const {
+        if (duration_ms == 0) {
+            return time;
+        }
+        return time - (time - epoch_ms) % duration_ms;
+    }
+
+    // where frame pixels came from, counted by telemetry
+    enum Origin { ORIGIN_NONE = 0, ORIGIN_RASTERIZED, ORIGIN_BAKED, ORIGIN_CACHED, ORIGIN_UNCHANGED };
+
+    // Render frame to dst or copy it, when another instance rendered it already. Returns version of
+    // frame, dst is not filled when it same as prevVersion, instance has these pixels already
+    uint32_t renderFrame(int index, LottieFrameBuffer &dst, uint32_t prevVersion, Origin &origin) {
+        std::lock_guard<std::mutex> lock(renderMutex);
+        origin = ORIGIN_NONE;
+        // model evicted, it will be loaded again by loader
+        if (!anim || index >= total) {
+            return NO_VERSION;
+        }
+
+        origin = ORIGIN_UNCHANGED;
+        if (prevVersion != NO_VERSION && frameVersions[index] == prevVersion) {
+            return prevVersion;
+        }
+
+        if (isBaked(index) && dst.size() == frameBytes()) {
+            origin = bakedFrames[index - bakeFirst] ? ORIGIN_BAKED : ORIGIN_RASTERIZED;
+            const uint8_t *data = bakeFrame(index);
+            if (frameVersions[index] != prevVersion) {
+                dst.write(data);
+            }
+            return frameVersions[index];
+        }
+
+        for (CachedFrame &c : cached) {
+            if (c.index == index && c.data.size() == dst.size()) {
+                origin = ORIGIN_CACHED;
+                dst.write(c.data.data());
+                return frameVersions[index];
+            }
+        }
+
+        // renderer not draw frame which same as last rendered, instance has it when versions equal
+        const bool skipUnchanged = prevVersion != NO_VERSION && prevVersion == version;
+        rasterize(index, dst.data(), dst.pitch, skipUnchanged);
+        if (version == prevVersion) {
+            return version;
+        }
+        origin = ORIGIN_RASTERIZED;
+
+        // nobody else can use this frame
+        if (refs < 2) {
+            return version;
+        }
+
+        CachedFrame &c = cached[nextCached];
+        nextCached = (nextCached + 1) % CACHED_FRAMES;
+        c.index = index;
+        dst.read(c.data);
+        return version;
+    }
+
+    void clearCache() {
+        for (CachedFrame &c : cached) {
+            c.index = -1;
+            c.data = std::vector<uint8_t>();
+        }
+    }
+};
+
+// Counters of frames, kept per animation and summed for all animations
+struct LottieFrameCounters {
+    uint64_t shown = 0;
+    // frames which were shown later than their time or skipped
+    uint64_t misses = 0;
+    // rasterized by renderer
+    uint64_t rendered = 0;
+    // copied from baked store or cache of source, or same as previous frame and not uploaded
+    uint64_t baked = 0;
+    uint64_t cached = 0;
+    uint64_t unchanged = 0;
+    // prerendered but late, never shown
+    uint64_t dropped = 0;
+    // never rendered, timeline jumped over them
+    uint64_t skipped = 0;
+
+    uint64_t reused() const { return baked + cached + unchanged; }
+
+    void count(LottieFrameSource::Origin origin) {
+        switch (origin) {
+        case LottieFrameSource::ORIGIN_RASTERIZED: rendered++; break;
+        case LottieFrameSource::ORIGIN_BAKED: baked++; break;
+        case LottieFrameSource::ORIGIN_CACHED: cached++; break;
+        case LottieFrameSource::ORIGIN_UNCHANGED: unchanged++; break;
+        default: break;
+        }
+    }
+
+    void add(const LottieFrameCounters &c) {
+        shown += c.shown;
+        misses += c.misses;
+        rendered += c.rendered;
+        baked += c.baked;
+        cached += c.cached;
+        unchanged += c.unchanged;
+        dropped += c.dropped;
+        skipped += c.skipped;
+    }
+};
+
+// Render times of last frames in microseconds, percentiles computed when stats published
+struct LottieTimeSamples {
+    static constexpr uint32_t COUNT = 64;
+    uint32_t us[COUNT] = {};
+    uint32_t added = 0;
+
+    void add(uint32_t v) {
+        us[added % COUNT] = v;
+        added++;
+    }
+
+    void copyTo(std::vector<uint32_t> &out) const {
+        out.insert(out.end(), us, us + std::min(added, COUNT));
+    }
+
+    // p of sorted samples, 0.5 for median
+    static float percentile(const std::vector<uint32_t> &sorted, float p) {
+        if (sorted.empty()) {
+            return 0.f;
+        }
+        return (float)sorted[std::min<size_t>(size_t(p * sorted.size()), sorted.size() - 1)];
+    }
+};
+
+// Data of animation which scheduler not read on every tick, path and telemetry. It kept in
+// side array of slot map, dense array of animations has only hot state of timelines
+struct LottieAnimCold {
+    std::string lottiePath;
+    // telemetry, copied to stats by render thread
+    LottieFrameCounters counters;
+    LottieTimeSamples renderTimes;
 };
 
-// Data in system memory, this frame ready for move to tmp atlas
-struct ReadyFrame {
-    ImGuiID pid = BAD_PICTUREID;
-    std::vector<uint8_t> data;
-    ImVec2 size;
-#if DEBUG_LOTTIE_UPDATE
-    const char *lottie = nullptr;
-    int frame = 0;
-    int duration_ms = 0;
-#endif
-};
+class LottieAnimationRenderer;
+namespace detail {
+    LottieAnimationRenderer *g_lottieRenderer = nullptr;
+}
+
+// This code defines a struct called LottieAnim, which represents a Lottie animation. It contains various static constants,
+// such as the default size and pre-rendered frames, as well as variables that store information about the animation
+// such as the timeline and frames.
+struct LottieAnim {
+    // default size for lottie renderer
+    static constexpr int DEFAULT_SIZE = 32;
+    // how many prerendered frames saved in array
+    static constexpr int DEFAULT_PRERENDERED_FRAMES = 2;
+    static constexpr int LOTTIE_SURFACE_FMT = sizeof(uint32_t); // TEXFMT_A8R8G8B8;
+    static constexpr int LOTTIE_SURFACE_FMT_BPP = sizeof(uint32_t);
+
+    // A unique identifier for the picture
+    ImGuiID pid = BAD_PICTUREID;
+
+    struct {
+        int width = DEFAULT_SIZE;
+        int height = DEFAULT_SIZE;
+    } canvas;
+
+    // times are in ms of render thread clock
+    struct {
+        // 64 bit, serial multiplied by it not overflow in long sessions
+        uint64_t duration_ms = 0;
+        // time when shown frame should be displayed
+        uint64_t last_ms = 0;
+        // time of frame 0, frame for display computed from it
+        uint64_t start_ms = 0;
+        uint64_t suspended_ms = 0;
+        bool started = false;
+        // segment changed or seek, timeline starts on next render from seekFrame (-1 start of segment)
+        bool restarted = false;
+        int seekFrame = -1;
+    } timeline;
+
+    // part of animation which is played, start and end (-1 last frame) or marker set by host.
+    // Resolved when model loaded, serials of timeline counted from first frame of segment
+    struct {
+        std::string marker;
+        int start = 0;
+        int end = -1;
+        int first = 0;
+    } segment;
+
+    // speed multiplier of playback, frames are shown for duration of source frame divided by it
+    static constexpr float MIN_SPEED = 0.05f;
+    static constexpr float MAX_SPEED = 20.f;
+    float speed = 1.f;
+
+    // serial of frame which was moved to current frame
+    static constexpr uint32_t NO_FRAME = UINT32_MAX;
+
+    struct {
+        uint16_t current = 0;
+        uint16_t total = 0;
+        uint32_t shown = NO_FRAME;
+        // version of pixels in texture, frames with same version not uploaded again
+        uint32_t version = LottieFrameSource::NO_VERSION;
+        // version of last frame passed to main thread, next one uploaded only where it differs
+        uint32_t pushed = LottieFrameSource::NO_VERSION;
+        // version which last passed frame is based on, frame replacing it before upload based on it too
+        uint32_t pushedBase = LottieFrameSource::NO_VERSION;
+    } frame;
+
+    // Flags for the animation
+    bool loop = false;
+    bool play = false;
+    bool renderonce = false;
+    // widget not visible for some time, animation not rendered until it shown again
+    bool suspended = false;
+
+    int maxPrerenderedFrames = DEFAULT_PRERENDERED_FRAMES;
+
+    // set by host per widget, 0 - background, 1 - normal, more for focused or hovered widgets.
+    // every step of priority schedule animation as its deadline was PRIORITY_STEP_MS earlier
+    static constexpr int DEFAULT_PRIORITY = 1;
+    static constexpr int PRIORITY_STEP_MS = 8;
+    int priority = DEFAULT_PRIORITY;
+
+    // 2 when quality governor halve frame rate, only every second frame rendered
+    uint32_t frameStep = 1;
+
+    // last counted miss, counters are in LottieAnimCold
+    uint32_t missedSerial = NO_FRAME;
+    // not count misses after start or resume, timeline jumps there
+    bool trackMisses = false;
+
+    // parsed animation, may be shared with other instances
+    LottieFrameSource *source = nullptr;
+    // we need save future frames, because are can have
+    // different time for render, thread render it on loop
+    LottieFixedRing<NextFrame> prerenderedFrames;
+
+    // here saved frame, which need for display, on every render()
+    // call prerendered frame will moved here when time for next frame gone
+    ReadyFrame currentFrame;
+
+    // newest frame for main thread, shared with animation desc of main thread
+    std::shared_ptr<LottieReadyFrames> readyFrames;
+
+    // Grabs the current frame and stores it in the "f" parameter, it must be without data.
+    // When previous grabbed frame was not taken by main thread yet, "f" replaces it and
+    // damage counted from frame which previous was based on
+    bool grabCurrentFrame(ReadyFrame &f, bool replacing) {
+        if (currentFrame.pid == BAD_PICTUREID) {
+            return false;
+        }
+
+        std::swap(f, currentFrame);
+        currentFrame.pid = BAD_PICTUREID;
+
+        const uint32_t base = replacing ? frame.pushedBase : frame.pushed;
+        f.baseVersion = base;
+        f.damage = source->damageSince(base, f.version);
+        frame.pushed = f.version;
+        frame.pushedBase = base;
+        return true;
+    }
+
+    // Returns a hash code based on the properties of the Lottie animation
+    // path hashed once and numbers are mixed to hash as raw data, without string formatting
+    static ImGuiID getPropsHash(const char *lottie, const int canvasWidth, const int canvasHeight, bool loop, int rate) {
+        const int props[] = { canvasWidth, canvasHeight, loop ? 1 : 0, rate };
+        return ImHashData(props, sizeof(props), ImHashStr(lottie, 0, 0xc001f00d));
+    }
+
+    // Loads the Lottie animation from the specified file path
+    bool load(LottieFrameSource *_source, const char *path, bool _loop, bool _play, int _prerenderedFrames, ImGuiID _pid) {
+        if (!_source || !path || 0 == *path) {
+            return false;
+        }
+
+        source = _source;
+        canvas.width = source->width;
+        canvas.height = source->height;
+
+        loop = _loop;
+        play = _play;
+        pid = _pid;
+        maxPrerenderedFrames = std::max<int>(_prerenderedFrames, DEFAULT_PRERENDERED_FRAMES);
+        // render() keep up to maxPrerenderedFrames + 1 frames
+        prerenderedFrames.reset(maxPrerenderedFrames + 1);
+        // timeline starts with first render
+        timeline.started = false;
+        frame.shown = NO_FRAME;
+        frame.current = 0;
+        frame.version = LottieFrameSource::NO_VERSION;
+        frame.pushed = LottieFrameSource::NO_VERSION;
+        frame.pushedBase = LottieFrameSource::NO_VERSION;
+        trackMisses = false;
+
+        syncSource();
+        return true;
+    }
+
+    // source loaded, animation can be played
+    void syncSource() {
+        canvas.width = source->width;
+        canvas.height = source->height;
+        resolveSegment();
+        timeline.duration_ms = source->duration_ms > 0 ? std::max<uint64_t>(uint64_t(source->duration_ms / speed), 1) : 0;
+    }
+
+    // frames of requested segment clamped to animation, whole animation when marker not found
+    void resolveSegment() {
+        const int total = source->total;
+        if (total == 0) {
+            segment.first = 0;
+            frame.total = 0;
+            return;
+        }
+
+        int first = segment.start;
+        int last = segment.end;
+        if (!segment.marker.empty() && !source->findMarker(segment.marker, first, last)) {
+            first = 0;
+            last = -1;
+        }
+        first = std::min(std::max(first, 0), total - 1);
+        last = (last < 0 || last >= total) ? total - 1 : std::max(last, first);
+        segment.first = first;
+        frame.total = uint16_t(last - first + 1);
+    }
+
+    // frame of animation for serial of timeline
+    uint16_t frameIndex(uint32_t serial) const {
+        return uint16_t(segment.first + (loop ? serial % frame.total : serial));
+    }
+
+    // plays frames start..end (or of marker) from start of segment
+    void setSegment(const std::string &marker, int start, int end, bool _loop, LottieFramePool &framePool) {
+        segment.marker = marker;
+        segment.start = start;
+        segment.end = end;
+        loop = _loop;
+        syncSource();
+        restart(-1, framePool);
+    }
+
+    // shows frame of animation now, it clamped to segment
+    void seek(int index, LottieFramePool &framePool) {
+        restart(index, framePool);
+    }
+
+    // position on timeline kept, only frames after it shown faster or slower
+    void setSpeed(float _speed, uint64_t curTime) {
+        _speed = std::min(std::max(_speed, MIN_SPEED), MAX_SPEED);
+        const uint32_t serial = targetSerial(curTime);
+        speed = _speed;
+        syncSource();
+        if (timeline.started && timeline.duration_ms > 0) {
+            timeline.start_ms = curTime - serial * timeline.duration_ms;
+            if (frame.shown != NO_FRAME) {
+                timeline.last_ms = timeline.start_ms + frame.shown * timeline.duration_ms;
+            }
+        }
+    }
+
+    // prerendered frames of old position never will be shown, texture keeps last shown frame until
+    // new one ready
+    void restart(int _seekFrame, LottieFramePool &framePool) {
+        evictFrames(framePool);
+        timeline.started = false;
+        timeline.restarted = true;
+        timeline.seekFrame = _seekFrame;
+        frame.shown = NO_FRAME;
+        trackMisses = false;
+        missedSerial = NO_FRAME;
+    }
+
+    // no frames need render for this animation until something changed from outside
+    static constexpr uint64_t NO_DEADLINE = UINT64_MAX;
+
+    // animation should be rendered, but model can be not loaded yet
+    bool wantsRender() const {
+        return pid != BAD_PICTUREID && !suspended && (play || renderonce);
+    }
+
+    bool active() const {
+        return wantsRender() && source->ready() && frame.total > 0 && timeline.duration_ms > 0;
+    }
+
+    // Frame which should be displayed now by wall clock
+    uint32_t targetSerial(uint64_t curTime) const {
+        if (!timeline.started) {
+            return 0;
+        }
+
+        uint32_t serial = uint32_t((curTime - timeline.start_ms) / timeline.duration_ms);
+        serial -= serial % frameStep;
+        return loop ? serial : std::min<uint32_t>(serial, frame.total - 1);
+    }
+
+    // not looped animation finished when its last frame was shown
+    bool finished() const {
+        return !loop && frame.shown != NO_FRAME && frame.shown + 1 >= frame.total;
+    }
+
+    // Which frame should be prerendered next, frames before target one never will be shown
+    uint32_t nextPrerenderSerial(uint32_t target) const {
+        if (prerenderedFrames.size() > 0) {
+            return std::max(prerenderedFrames.back().serial + frameStep, target);
+        }
+        // shown frame can be ahead of target after frame rate was halved
+        if (frame.shown != NO_FRAME && frame.shown >= target) {
+            return frame.shown + frameStep;
+        }
+        return target;
+    }
+
+    bool needPrerender(uint32_t target) const {
+        if (prerenderedFrames.size() > (size_t)std::max<int>(maxPrerenderedFrames, DEFAULT_PRERENDERED_FRAMES)) {
+            return false;
+        }
+        return loop || nextPrerenderSerial(target) < frame.total;
+    }
+
+    // Returns time when render() should be called next time for this animation
+    uint64_t nextDeadline(uint64_t curTime) const {
+        if (!active() || finished())
+            return NO_DEADLINE;
+
+        // prerendered frames are not enough or nothing shown yet, need render now
+        const uint32_t target = targetSerial(curTime);
+        if (needPrerender(target) || frame.shown == NO_FRAME || frame.shown < target) {
+            return curTime;
+        }
+
+        return timeline.last_ms + timeline.duration_ms * frameStep;
+    }
+
+    // Stop or continue rendering, timeline paused while animation suspended
+    void suspend(bool _suspended, uint64_t curTime) {
+        if (!suspended && _suspended) {
+            timeline.suspended_ms = curTime;
+        } else if (suspended && !_suspended && timeline.started) {
+            trackMisses = false;
+            // looped copies just follow shared phase, once played continue from same frame
+            if (!loop) {
+                timeline.start_ms = source->alignedStart(timeline.start_ms + curTime - timeline.suspended_ms);
+            }
+            if (frame.shown != NO_FRAME) {
+                timeline.last_ms = timeline.start_ms + frame.shown * timeline.duration_ms;
+            }
+        }
+        suspended = _suspended;
+    }
+
+    // returns prerendered frames to pool, they rendered again when needed
+    void evictFrames(LottieFramePool &framePool) {
+        while (prerenderedFrames.size() > 0) {
+            framePool.release(prerenderedFrames.front().data);
+            prerenderedFrames.pop();
+        }
+    }
+
+    // frame never will be shown, next frame with same pixels takes its buffer
+    void dropFrontFrame(LottieFramePool &framePool, LottieFrameCounters &counters) {
+        counters.dropped++;
+        NextFrame &stale = prerenderedFrames.front();
+        prerenderedFrames.pop();
+        if (prerenderedFrames.size() > 0 && prerenderedFrames.front().data.empty() && prerenderedFrames.front().version == stale.version) {
+            std::swap(prerenderedFrames.front().data, stale.data);
+        }
+        framePool.release(stale.data);
+    }
+
+    // move first of prerendered frames to readyFrame, render thread
+    // after render it will be published to readyFrames
+    void showFrontFrame(LottieFramePool &framePool, LottieFrameCounters &counters) {
+        // frame without data has same pixels as texture or not grabbed current frame
+        NextFrame &nextFrame = prerenderedFrames.front();
+        if (!nextFrame.data.empty()) {
+            // if previous current frame was not grabbed his buffer back to pool
+            std::swap(currentFrame.data, nextFrame.data);
+            currentFrame.size = nextFrame.size;
+            currentFrame.version = nextFrame.version;
+            currentFrame.pid = pid;
+            framePool.release(nextFrame.data);
+        }
+
+        frame.shown = nextFrame.serial;
+        frame.version = nextFrame.version;
+        frame.current = frameIndex(frame.shown);
+        timeline.last_ms = timeline.start_ms + frame.shown * timeline.duration_ms;
+        source->lastShown_ms.store(timeline.last_ms, std::memory_order_relaxed);
+        prerenderedFrames.pop();
+        counters.shown++;
+        trackMisses = true;
+    }
+
+    // target frame not ready in time, count every missed target once
+    void countMiss(uint32_t target, LottieFrameCounters &counters) {
+        if (trackMisses && frame.shown != NO_FRAME && target != missedSerial) {
+            counters.misses++;
+            missedSerial = target;
+        }
+    }
+
+    // Returns time when frame which will be rendered next must be on screen, scheduler render
+    // animations with earliest time first
+    uint64_t scheduleDeadline(uint64_t curTime) const {
+        if (!timeline.started) {
+            return curTime;
+        }
+
+        // target frame is late already, it still useful until next frame time
+        const uint32_t target = targetSerial(curTime);
+        if (frame.shown == NO_FRAME || frame.shown < target) {
+            return timeline.start_ms + (target + frameStep) * timeline.duration_ms;
+        }
+        return timeline.start_ms + nextPrerenderSerial(target) * timeline.duration_ms;
+    }
+
+    bool render(uint64_t curTime, LottieFramePool &framePool, LottieAnimCold &cold) {
+        if (!active())
+            return false;
+
+        renderonce = false;
+        if (finished())
+            return false;
+
+        // start on frame grid of source, so instances render same frames at same time
+        if (!timeline.started) {
+            timeline.started = true;
+            timeline.start_ms = loop ? source->epoch_ms : source->alignedStart(curTime);
+        }
+
+        // segment or seek play from requested frame right now
+        if (timeline.restarted) {
+            timeline.restarted = false;
+            const int serial = timeline.seekFrame - segment.first;
+            const uint32_t from = serial > 0 ? std::min<uint32_t>(serial, frame.total - 1) : 0;
+            timeline.start_ms = curTime - from * timeline.duration_ms;
+        }
+
+        // frame which should be on screen now, by wall clock not by count of rendered frames
+        const uint32_t target = targetSerial(curTime);
+
+        // frames between shown and target never will be on screen
+        if (frame.shown != NO_FRAME && target > frame.shown + frameStep) {
+            countMiss(target, cold.counters);
+        }
+
+        // animation is late, frames before target are stale and never will be shown
+        while (prerenderedFrames.size() > 0 && prerenderedFrames.front().serial < target) {
+            dropFrontFrame(framePool, cold.counters);
+        }
+
+        if (prerenderedFrames.size() > 0 && prerenderedFrames.front().serial == target && frame.shown != target) {
+            showFrontFrame(framePool, cold.counters);
+        }
+
+        if (!needPrerender(target)) {
+            return false;
+        }
+
+        // jump directly to frame which will be displayed
+        const uint32_t nextSerial = nextPrerenderSerial(target);
+
+        // frames between previous rendered and next one never will be rendered
+        const uint32_t expectedSerial = prerenderedFrames.size() > 0 ? prerenderedFrames.back().serial + frameStep
+                                      : (frame.shown != NO_FRAME ? frame.shown + frameStep : nextSerial);
+        if (nextSerial > expectedSerial) {
+            cold.counters.skipped += (nextSerial - expectedSerial) / frameStep;
+        }
+
+        // if loop we need back to first frame of segment and render again
+        const uint16_t nextFrameIndex = frameIndex(nextSerial);
+
+        // previous frame in display order, texture keep its pixels when next frame is same
+        const uint32_t prevVersion = prerenderedFrames.size() > 0 ? prerenderedFrames.back().version : frame.version;
+
+        // create new frame
+        NextFrame &nextFrame = prerenderedFrames.push();
+        nextFrame.serial = nextSerial;
+
+        // take memory block where will be placed frame, it returns to pool after upload
+        framePool.acquire(canvas.width, canvas.height, nextFrame.data);
+
+        // save frame size for next actions
+        nextFrame.size = ImVec2((float)canvas.width, (float)canvas.height);
+
+        const auto renderStart = std::chrono::steady_clock::now();
+        LottieFrameSource::Origin origin;
+        nextFrame.version = source->renderFrame(nextFrameIndex, nextFrame.data, prevVersion, origin);
+        cold.renderTimes.add((uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - renderStart).count());
+        cold.counters.count(origin);
+        if (nextFrame.version != LottieFrameSource::NO_VERSION && nextFrame.version == prevVersion) {
+            framePool.release(nextFrame.data);
+        }
+
+        // target frame was missed, show it right after render
+        if (nextSerial == target && frame.shown != target) {
+            countMiss(target, cold.counters);
+            showFrontFrame(framePool, cold.counters);
+        }
+        return true;
+    }
+
+};
+
+struct LottieRenderCommand {
+    enum Type { UNKNOWN = 0, ADD_CONFIG, DISCARD_PID, SETUP_PID, SETUP_PLAY, SETUP_RENDER, SETUP_SUSPEND, SUBMIT_BATCH,
+                SETUP_SEGMENT, SETUP_SEEK, SETUP_SPEED };
+    Type type;
+    // file for ADD_CONFIG, marker for SETUP_SEGMENT
+    std::string path;
+    int w, h;
+    int loop;
+    int rate;
+    ImGuiID pid;
+    bool play;
+    bool render;
+    bool suspend;
+    // where frames of animation passed to main thread, for ADD_CONFIG
+    std::shared_ptr<LottieReadyFrames> readyFrames;
+    // segment frames for SETUP_SEGMENT, frame for SETUP_SEEK
+    int startFrame;
+    int endFrame;
+    float speed;
+    // animations drawn on one imgui frame and their priorities, for SUBMIT_BATCH
+    std::vector<ImGuiID> pids;
+    std::vector<int> priorities;
+};
+
+// Bounded lock-free queue for many producers and one consumer, all slots allocated once
+// on construction and values are swapped in/out, so queue never allocate memory later.
+// Capacity must be power of two.
+template<typename T, size_t Capacity>
+struct LottieMpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be power of two");
+
+    struct Slot {
+        std::atomic<size_t> sequence{0};
+        T value;
+    };
+
+    std::unique_ptr<Slot[]> slots{new Slot[Capacity]};
+    alignas(64) std::atomic<size_t> head{0}; // producers side
+    alignas(64) std::atomic<size_t> tail{0}; // consumer side
+
+    LottieMpscQueue() {
+        for (size_t i = 0; i < Capacity; ++i) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    // returns false when queue full
+    bool push(const T &value) {
+        size_t pos;
+        Slot *slot = claim(pos);
+        if (!slot) {
+            return false;
+        }
+
+        slot->value = value;
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // value swapped with slot, on success value gets what consumer left in slot, so producer
+    // reuses memory of previous values and big values are passed without allocation
+    bool push(T &&value) {
+        size_t pos;
+        Slot *slot = claim(pos);
+        if (!slot) {
+            return false;
+        }
+
+        std::swap(slot->value, value);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // reserve free slot for producer, null when queue full
+    Slot *claim(size_t &pos) {
+        pos = head.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot &slot = slots[pos & (Capacity - 1)];
+            const size_t seq = slot.sequence.load(std::memory_order_acquire);
+            const intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    return &slot;
+                }
+            } else if (diff < 0) {
+                return nullptr;
+            } else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool pop(T &value) {
+        const size_t pos = tail.load(std::memory_order_relaxed);
+        Slot &slot = slots[pos & (Capacity - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != pos + 1) {
+            return false;
+        }
+
+        std::swap(value, slot.value);
+        slot.sequence.store(pos + Capacity, std::memory_order_release);
+        tail.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // exact only for consumer thread
+    bool empty() const {
+        const size_t pos = tail.load(std::memory_order_relaxed);
+        return slots[pos & (Capacity - 1)].sequence.load(std::memory_order_acquire) != pos + 1;
+    }
+
+    // approximate, only for statistics
+    size_t size() const {
+        const size_t h = head.load(std::memory_order_relaxed);
+        const size_t t = tail.load(std::memory_order_relaxed);
+        return h > t ? h - t : 0;
+    }
+};
+
+// Generational slot map, values stored in dense array so render loop scan them
+// linearly, keys stay valid while value alive and slot reuse change generation.
+// Every value also indexed by its pid, so commands find animation in O(1).
+// Cold part of every value is in parallel array with same dense index
+template<typename T, typename Cold>
+struct LottieSlotMap {
+    struct Key {
+        uint32_t index = UINT32_MAX;
+        uint32_t generation = 0;
+    };
+
+    struct Slot {
+        uint32_t dense = 0;
+        uint32_t generation = 0;
+    };
+
+    std::vector<T> values;
+    std::vector<Cold> colds;
+    std::vector<uint32_t> denseToSlot;
+    std::vector<ImGuiID> densePids;
+    std::vector<Slot> slots;
+    std::vector<uint32_t> freeSlots;
+    std::unordered_map<ImGuiID, Key> pidIndex;
+
+    size_t size() const { return values.size(); }
+    bool empty() const { return values.empty(); }
+    T &operator[](size_t dense) { return values[dense]; }
+    Cold &cold(size_t dense) { return colds[dense]; }
+    // value must be from this map
+    Cold &coldOf(const T &value) { return colds[&value - values.data()]; }
+    typename std::vector<T>::iterator begin() { return values.begin(); }
+    typename std::vector<T>::iterator end() { return values.end(); }
+
+    // value with same pid will be replaced
+    Key insert(ImGuiID pid, T &&value, Cold &&cold) {
+        erasePid(pid);
+
+        uint32_t index;
+        if (!freeSlots.empty()) {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            index = (uint32_t)slots.size();
+            slots.push_back({});
+        }
+
+        slots[index].dense = (uint32_t)values.size();
+        values.push_back(std::move(value));
+        colds.push_back(std::move(cold));
+        denseToSlot.push_back(index);
+        densePids.push_back(pid);
+
+        Key key{index, slots[index].generation};
+        pidIndex[pid] = key;
+        return key;
+    }
+
+    T *find(Key key) {
+        if (key.index >= slots.size() || slots[key.index].generation != key.generation) {
+            return nullptr;
+        }
+        return &values[slots[key.index].dense];
+    }
+
+    T *findPid(ImGuiID pid) {
+        auto it = pidIndex.find(pid);
+        return it == pidIndex.end() ? nullptr : find(it->second);
+    }
+
+    void erase(Key key) {
+        if (!find(key)) {
+            return;
+        }
+
+        // last value moved to place of removed one, array stays dense
+        const uint32_t dense = slots[key.index].dense;
+        const uint32_t last = (uint32_t)values.size() - 1;
+        if (dense != last) {
+            values[dense] = std::move(values[last]);
+            colds[dense] = std::move(colds[last]);
+            denseToSlot[dense] = denseToSlot[last];
+            densePids[dense] = densePids[last];
+            slots[denseToSlot[dense]].dense = dense;
+        }
+        values.pop_back();
+        colds.pop_back();
+        denseToSlot.pop_back();
+        densePids.pop_back();
+
+        slots[key.index].generation++;
+        freeSlots.push_back(key.index);
+    }
+
+    void erasePid(ImGuiID pid) {
+        auto it = pidIndex.find(pid);
+        if (it != pidIndex.end()) {
+            Key key = it->second;
+            pidIndex.erase(it);
+            erase(key);
+        }
+    }
+
+    // index value by new pid
+    bool rekey(ImGuiID from, ImGuiID to) {
+        auto it = pidIndex.find(from);
+        if (it == pidIndex.end() || !find(it->second)) {
+            return false;
+        }
+
+        Key key = it->second;
+        pidIndex.erase(it);
+        erasePid(to);
+        pidIndex[to] = key;
+        densePids[slots[key.index].dense] = to;
+        return true;
+    }
+};
+
+// Counters of render thread queues, can be read from any thread.
+// Overflowed commands not fit to full queue and waited in overflow list, they are not lost.
+// Ready frames depth is count of animations with frame waiting for upload, dropped frames
+// were replaced by newer frame of same animation before main thread took them
+struct LottieQueueStats {
+    size_t commandsDepth = 0;
+    size_t readyFramesDepth = 0;
+    uint64_t commandsOverflowed = 0;
+    uint64_t readyFramesDropped = 0;
+};
+
+// Counters of one animation, published by render thread few times per second
+struct LottieAnimStats {
+    ImGuiID pid = BAD_PICTUREID;
+    int priority = 0;
+    std::string path;
+    // canvas which frames rendered now, can be reduced by quality governor
+    int width = 0;
+    int height = 0;
+    int frame = 0;
+    int totalFrames = 0;
+    bool baked = false;
+    bool suspended = false;
+    uint32_t framesShown = 0;
+    // frames which were shown later than their time or skipped
+    uint32_t deadlineMisses = 0;
+    uint32_t framesRendered = 0;
+    // copied from baked store or other instance, or same as previous frame
+    uint32_t framesReused = 0;
+    // prerendered but late, never shown
+    uint32_t framesDropped = 0;
+    // never rendered, timeline jumped over them
+    uint32_t framesSkipped = 0;
+    // time of render or copy of last frames
+    float renderUsP50 = 0.f;
+    float renderUsP99 = 0.f;
+    // bytes copied to atlas, counted by main thread
+    uint64_t uploadBytes = 0;
+};
+
+// State of quality governor, it reduce quality when render thread has no time for all animations
+struct LottieQualityState {
+    bool enabled = true;
+    // 0 - full quality, every next level reduce more
+    int level = 0;
+    // canvas size multiplier for not baked animations, frames upscaled on draw
+    float canvasScale = 1.f;
+    // animations with priority 0 render every second frame
+    bool lowPriorityHalfRate = false;
+    // share of time when render thread was busy during last period
+    float busy = 0.f;
+    uint64_t degrades = 0;
+    uint64_t restores = 0;
+};
+
+// Memory of models and frames in system memory, textures not included
+struct LottieMemoryStats {
+    size_t budget = 0;
+    size_t current = 0;
+    size_t peak = 0;
+    // how many times caches or models of animations were evicted by budget
+    uint64_t evictions = 0;
+};
+
+// Counters of all animations together, removed animations included
+struct LottieMetrics {
+    size_t animations = 0;
+    size_t sources = 0;
+    uint64_t framesShown = 0;
+    uint64_t deadlineMisses = 0;
+    uint64_t framesRendered = 0;
+    uint64_t framesDropped = 0;
+    uint64_t framesSkipped = 0;
+    // reused frames by their origin
+    uint64_t bakedHits = 0;
+    uint64_t cacheHits = 0;
+    uint64_t unchangedHits = 0;
+    // share of frames which were not rasterized
+    float reuseRate = 0.f;
+    // time of render or copy of recent frames of all animations
+    float renderUsP50 = 0.f;
+    float renderUsP99 = 0.f;
+    uint64_t uploads = 0;
+    uint64_t uploadBytes = 0;
+    // frames left for next sync() because upload budget was spent
+    uint64_t uploadsDeferred = 0;
+    LottieQueueStats queues;
+    LottieMemoryStats memory;
+    LottieQualityState quality;
+};
+
+// Pool of render workers, render thread split animations between workers on every tick.
+// Every worker own continuous range of task indices and take tasks from it, when range
+// finished worker steal tasks from ranges of other workers, so one heavy animation
+// not block others. Caller thread works as worker 0 and waits until all tasks done.
+struct LottieWorkerPool {
+    // zero mean use all cores
+    static constexpr int DEFAULT_WORKERS = 0;
+
+    struct alignas(64) Range {
+        std::atomic<size_t> next{0};
+        size_t end = 0;
+    };
+
+    std::vector<std::thread> threads;
+    std::unique_ptr<Range[]> ranges;
+    int workersCount = 1;
+
+    // current batch, task is index in [0, tasksCount)
+    void (*job)(void *ctx, size_t index) = nullptr;
+    void *jobCtx = nullptr;
+    std::atomic<size_t> tasksLeft{0};
+
+    std::mutex wakeMutex;
+    std::condition_variable wakeWorkers;
+    std::condition_variable wakeCaller;
+    uint32_t generation = 0;
+    int activeWorkers = 0;
+    bool terminating = false;
+
+    void start(int workers) {
+        if (workers <= 0) {
+            workers = (int)std::max<unsigned>(std::thread::hardware_concurrency(), 1);
+        }
+
+        workersCount = workers;
+        ranges.reset(new Range[workersCount]);
+        for (int i = 1; i < workersCount; ++i) {
+            threads.emplace_back([this, i] () { workerLoop(i); });
+        }
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            terminating = true;
+        }
+        wakeWorkers.notify_all();
+        for (auto &t : threads) {
+            t.join();
+        }
+        threads.clear();
+    }
+
+    // run fn(index) for every index in [0, count), returns when all tasks finished
+    template<typename Fn>
+    void parallelFor(size_t count, Fn &fn) {
+        if (count == 0) {
+            return;
+        }
+
+        if (workersCount == 1 || count == 1) {
+            for (size_t i = 0; i < count; ++i) {
+                fn(i);
+            }
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            job = [] (void *ctx, size_t index) { (*(Fn *)ctx)(index); };
+            jobCtx = &fn;
+
+            // split tasks to equal ranges, rest of tasks will be stolen
+            const size_t chunk = (count + workersCount - 1) / workersCount;
+            for (int i = 0; i < workersCount; ++i) {
+                size_t begin = std::min<size_t>(chunk * i, count);
+                ranges[i].next.store(begin, std::memory_order_relaxed);
+                ranges[i].end = std::min<size_t>(begin + chunk, count);
+            }
+            tasksLeft.store(count);
+            generation++;
+        }
+        wakeWorkers.notify_all();
+
+        runTasks(0);
+
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        // wait also for workers which still leave batch, ranges can't be changed under them
+        wakeCaller.wait(lock, [this] () { return tasksLeft.load() == 0 && activeWorkers == 0; });
+        job = nullptr;
+        jobCtx = nullptr;
+    }
+
+    void runTasks(int worker) {
+        // own range first, then try steal from neighbours
+        for (int i = 0; i < workersCount; ++i) {
+            Range &range = ranges[(worker + i) % workersCount];
+            for (;;) {
+                size_t index = range.next.fetch_add(1);
+                if (index >= range.end) {
+                    break;
+                }
+
+                job(jobCtx, index);
+                tasksLeft.fetch_sub(1);
+            }
+        }
+    }
+
+    void workerLoop(int worker) {
+        uint32_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(wakeMutex);
+                wakeWorkers.wait(lock, [&] () { return terminating || seen != generation; });
+                if (terminating) {
+                    return;
+                }
+
+                // batch may be already finished by other workers
+                seen = generation;
+                if (!job) {
+                    continue;
+                }
+                activeWorkers++;
+            }
+
+            runTasks(worker);
+
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            if (--activeWorkers == 0) {
+                wakeCaller.notify_one();
+            }
+        }
+    }
+};
+
+// Time source of render thread, all timelines and deadlines use it. Milliseconds in 64 bit
+// from any start point, must never go back
+struct LottieClock {
+    virtual ~LottieClock() = default;
+    virtual uint64_t nowMs() = 0;
+    // time moves by itself, thread sleeps until deadline. Other clocks wake thread by onAdvance
+    virtual bool realtime() const { return true; }
+
+    // set by render thread before it started
+    void (*onAdvance)(void *ctx) = nullptr;
+    void *onAdvanceCtx = nullptr;
+};
+
+// Default clock, monotonic time from its creation
+struct LottieSteadyClock : LottieClock {
+    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+    uint64_t nowMs() override {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startTime).count();
+    }
+};
+
+// Virtual time stepped by host, scheduler with it behaves same on every run. Headless tests
+// advance clock, call ImLottie::waitIdle() and check frames
+struct LottieManualClock : LottieClock {
+    std::atomic<uint64_t> now{0};
+
+    uint64_t nowMs() override {
+        return now.load(std::memory_order_acquire);
+    }
+
+    bool realtime() const override { return false; }
+
+    void advance(uint64_t ms) {
+        set(now.load(std::memory_order_relaxed) + ms);
+    }
+
+    void set(uint64_t ms) {
+        now.store(ms, std::memory_order_release);
+        if (onAdvance) {
+            onAdvance(onAdvanceCtx);
+        }
+    }
+};
+
+// this thread resolve command to load lotti animations, and their render frames
+struct LottieRenderThread {
+    // how many commands can wait in queue
+    static constexpr size_t MAX_COMMANDS = 1024;
+
+    std::atomic_int terminating = false;
+    bool popCommand(LottieRenderCommand &command) {
+        return commands.pop(command);
+    }
+
+    // command never lost, when queue full it waits in overflow list and all next commands
+    // go there too until render thread resolve them, so order of commands stays same
+    void addCommand(const LottieRenderCommand &command) {
+        if (commandsOverflowing.load(std::memory_order_acquire) || !commands.push(command)) {
+            std::lock_guard<std::mutex> lock(overflowMutex);
+            overflowCommands.push_back(command);
+            commandsOverflowing.store(true, std::memory_order_release);
+            commandsOverflowed.fetch_add(1, std::memory_order_relaxed);
+        }
+        wakeupForCommand();
+    }
+
+    // command is swapped with queue slot, after call it keeps old content of slot
+    // and its vectors can be filled again without allocation
+    void addCommand(LottieRenderCommand &&command) {
+        if (commandsOverflowing.load(std::memory_order_acquire) || !commands.push(std::move(command))) {
+            std::lock_guard<std::mutex> lock(overflowMutex);
+            overflowCommands.push_back(std::move(command));
+            commandsOverflowing.store(true, std::memory_order_release);
+            commandsOverflowed.fetch_add(1, std::memory_order_relaxed);
+        }
+        wakeupForCommand();
+    }
+
+    void wakeupForCommand() {
+        // pair for fence in waitNextDeadline(), or thread see command or we see it sleeping
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping.load(std::memory_order_relaxed)) {
+            wakeup();
+        }
+    }
+
+    void wakeup() {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        wakeCondition.notify_one();
+    }
+
+    std::thread independentThread;
+    // all loaded animations, dense array scanned every tick
+    LottieSlotMap<LottieAnim, LottieAnimCold> animations;
+
+    // parsed animations by file, canvas and rate, counted by animations which use it
+    std::unordered_map<ImGuiID, LottieFrameSource> sources;
+
+    // animation with all frames smaller than budget is baked, 64x64 loop of 120 frames fit to default
+    static constexpr size_t DEFAULT_BAKE_BUDGET = 2 * 1024 * 1024;
+    // thread not start bake frame when deadline is nearer
+    static constexpr uint32_t BAKE_SLACK_MS = 2;
+    std::atomic<size_t> bakeBudget{DEFAULT_BAKE_BUDGET};
+
+    // all frames and models should fit to memory budget, 0 mean no limit
+    static constexpr size_t DEFAULT_MEMORY_BUDGET = 256 * 1024 * 1024;
+    std::atomic<size_t> memoryBudget{DEFAULT_MEMORY_BUDGET};
+    std::atomic<size_t> memoryCurrent{0};
+    std::atomic<size_t> memoryPeak{0};
+    std::atomic<uint64_t> memoryEvictions{0};
+
+    size_t memoryUsed() const {
+        size_t bytes = framePool.liveBytes.load(std::memory_order_relaxed);
+        for (const auto &it : sources) {
+            bytes += it.second.memoryBytes();
+        }
+        return bytes;
+    }
+
+    // evict least recently shown sources until memory fit to budget, first free buffers
+    // from pool, then frames of sources, models only when all instances not rendered
+    void enforceMemoryBudget() {
+        size_t used = memoryUsed();
+        memoryPeak.store(std::max(memoryPeak.load(std::memory_order_relaxed), used), std::memory_order_relaxed);
+
+        const size_t budget = memoryBudget.load(std::memory_order_relaxed);
+        if (budget > 0 && used > budget) {
+            framePool.trim();
+            used = memoryUsed();
+        }
+
+        if (budget > 0 && used > budget) {
+            std::vector<LottieFrameSource *> lru;
+            for (auto &it : sources) {
+                lru.push_back(&it.second);
+            }
+            std::sort(lru.begin(), lru.end(), [] (const LottieFrameSource *a, const LottieFrameSource *b) {
+                return a->lastShown_ms.load(std::memory_order_relaxed) < b->lastShown_ms.load(std::memory_order_relaxed);
+            });
+
+            for (LottieFrameSource *source : lru) {
+                if (used <= budget) {
+                    break;
+                }
+
+                bool inUse = false;
+                for (LottieAnim &anim : animations) {
+                    if (anim.source == source && anim.active() && !anim.finished()) {
+                        inUse = true;
+                    }
+                }
+
+                if (inUse) {
+                    source->evictFrames();
+                } else {
+                    source->evictModel();
+                    for (LottieAnim &anim : animations) {
+                        if (anim.source == source) {
+                            anim.evictFrames(framePool);
+                        }
+                    }
+                }
+                framePool.trim();
+                const size_t before = used;
+                used = memoryUsed();
+                if (used < before) {
+                    memoryEvictions.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        memoryCurrent.store(used, std::memory_order_relaxed);
+    }
+
+    LottieMemoryStats memoryStats() const {
+        LottieMemoryStats stats;
+        stats.budget = memoryBudget.load(std::memory_order_relaxed);
+        stats.current = memoryCurrent.load(std::memory_order_relaxed);
+        stats.peak = memoryPeak.load(std::memory_order_relaxed);
+        stats.evictions = memoryEvictions.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    // bake one frame of any source, returns false when nothing to bake
+    bool bakeStep() {
+        for (auto &it : sources) {
+            if (it.second.bakeNext()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    LottieFrameSource *acquireSource(const char *path, int w, int h, int rate) {
+        if (!path || 0 == *path) {
+            return nullptr;
+        }
+
+        w = std::max<int>(w, LottieAnim::DEFAULT_SIZE);
+        h = std::max<int>(h, LottieAnim::DEFAULT_SIZE);
+        const ImGuiID key = LottieFrameSource::getKey(path, w, h, rate);
+        LottieFrameSource &source = sources.try_emplace(key).first->second;
+        if (source.refs == 0) {
+            source.init(key, path, w, h, rate);
+            requestLoad(source);
+        }
+
+        source.refs++;
+        return &source;
+    }
+
+    // file parsed by loader, animations wait for model without frames
+    LottieLoader loader;
+    std::vector<LottieLoader::Result> loadedModels;
+
+    void requestLoad(LottieFrameSource &source) {
+        if (source.loading || source.failed) {
+            return;
+        }
+
+        source.loading = true;
+        source.loadTicket++;
+        loader.post({ source.key, source.loadTicket, source.path });
+    }
+
+    void applyLoadedModels() {
+        if (!loader.hasResults()) {
+            return;
+        }
+
+        loader.takeResults(loadedModels);
+        for (LottieLoader::Result &result : loadedModels) {
+            // source was removed or loaded again while job in queue
+            auto it = sources.find(result.key);
+            if (it == sources.end() || !it->second.loading || it->second.loadTicket != result.ticket) {
+                continue;
+            }
+
+            LottieFrameSource &source = it->second;
+            source.applyLoaded(result, nowMs());
+            for (LottieAnim &anim : animations) {
+                if (anim.source == &source) {
+                    anim.syncSource();
+                }
+            }
+            updateBakeRange(source);
+        }
+        loadedModels.clear();
+    }
+
+    // only frames of segments played by instances of source are baked
+    void updateBakeRange(LottieFrameSource &source) {
+        if (!source.ready()) {
+            return;
+        }
+
+        int first = source.total;
+        int last = -1;
+        for (const LottieAnim &anim : animations) {
+            if (anim.source == &source && anim.frame.total > 0) {
+                first = std::min(first, anim.segment.first);
+                last = std::max(last, anim.segment.first + anim.frame.total - 1);
+            }
+        }
+        if (last >= first) {
+            source.setBakeRange(first, last - first + 1, bakeBudget.load(std::memory_order_relaxed));
+        }
+    }
+
+    // models evicted by memory budget loaded again when animation shown
+    void requestEvictedModels() {
+        for (LottieAnim &anim : animations) {
+            if (anim.wantsRender() && !anim.source->anim) {
+                requestLoad(*anim.source);
+            }
+        }
+    }
+
+    void releaseSource(LottieFrameSource *source) {
+        if (!source) {
+            return;
+        }
+
+        source->refs--;
+        if (source->refs > 0) {
+            // single instance not use cache
+            if (source->refs == 1) {
+                source->clearCache();
+            }
+            return;
+        }
+
+        sources.erase(source->key);
+    }
+
+    void discardAnimation(ImGuiID pid) {
+        if (LottieAnim *anim = animations.findPid(pid)) {
+            retiredCounters.add(animations.coldOf(*anim).counters);
+            anim->evictFrames(framePool);
+            framePool.release(anim->currentFrame.data);
+            if (anim->readyFrames) {
+                // main thread already forgot animation, frame waiting for it not uploaded
+                releaseReadyFrames(*anim->readyFrames);
+            }
+            releaseSource(anim->source);
+            animations.erasePid(pid);
+        }
+    }
+
+    // workers which render animations, render thread is one of them
+    LottieWorkerPool workers;
+
+    // this queue contain commands for animations, it may be filled from any thread
+    // load - load animation may take much time
+    // discard - after reset\remove image in PM we need remove it from quese
+    //           because PM cant contain real image for it
+    // setup pid - animation need assign PictureID in PM, this pid
+    //             received later than load, when we have area in atlas for image
+    // setup play flag - for future, when we need change play status
+    LottieMpscQueue<LottieRenderCommand, MAX_COMMANDS> commands;
+    // commands which not fit to queue, resolved after queue emptied
+    std::mutex overflowMutex;
+    std::vector<LottieRenderCommand> overflowCommands;
+    std::vector<LottieRenderCommand> resolvingCommands;
+    std::atomic<bool> commandsOverflowing{false};
+    std::atomic<uint64_t> commandsOverflowed{0};
+
+    bool hasCommands() const {
+        return !commands.empty() || commandsOverflowing.load(std::memory_order_acquire);
+    }
+
+    // queue is empty here, older commands already resolved
+    void resolveOverflowCommands() {
+        if (!commandsOverflowing.load(std::memory_order_acquire)) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(overflowMutex);
+            std::swap(resolvingCommands, overflowCommands);
+        }
+        for (const LottieRenderCommand &cmd : resolvingCommands) {
+            resolveCommand(cmd);
+        }
+        resolvingCommands.clear();
+
+        // commands added meanwhile stay in list, producers keep adding there until it empty
+        std::lock_guard<std::mutex> lock(overflowMutex);
+        if (overflowCommands.empty()) {
+            commandsOverflowing.store(false, std::memory_order_release);
+        }
+    }
+
+    // ready frames are passed to main thread by triple buffer of every animation, they
+    // placed in system memory that another thread can copy their to PM texture later
+    std::atomic<size_t> readyFramesPending{0};
+    std::atomic<uint64_t> readyFramesDropped{0};
+
+    // thread sleep until nearest frame deadline of animations or new command
+    std::mutex sleepMutex;
+    std::condition_variable wakeCondition;
+    std::atomic<bool> sleeping{false};
+    // deadline which thread sleeps until, guarded by sleepMutex
+    uint64_t sleepDeadline_ms = 0;
+    std::condition_variable idleCondition;
+
+    // all animation timelines use it, set before thread started
+    std::unique_ptr<LottieClock> clock;
+
+    void setClock(LottieClock *_clock) {
+        clock.reset(_clock ? _clock : new LottieSteadyClock());
+        clock->onAdvance = [] (void *ctx) { ((LottieRenderThread *)ctx)->wakeup(); };
+        clock->onAdvanceCtx = this;
+    }
+
+    uint64_t nowMs() const {
+        return clock->nowMs();
+    }
+
+    // caller waits until thread rendered everything due at current time of clock and fall asleep,
+    // commands sent before and loading models are finished too
+    void waitIdle() {
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        idleCondition.wait(lock, [this] () {
+            return terminating.load() || (sleeping.load(std::memory_order_relaxed) && nowMs() < sleepDeadline_ms && !hasCommands() && loader.idle());
+        });
+    }
+
+    // pixel buffers of frames, shared by render and main thread
+    LottieFramePool framePool;
+
+    // main thread not take frames, only newest frame of animation waits and older one
+    // goes back to pool, so animation never hold more than one frame for upload
+    void publishReadyFrame(LottieAnim &anim) {
+        LottieReadyFrames &ready = *anim.readyFrames;
+        if (!anim.grabCurrentFrame(ready.back(), ready.pending())) {
+            return;
+        }
+
+        // counted before publish, main thread can take frame at once
+        readyFramesPending.fetch_add(1, std::memory_order_relaxed);
+        if (ready.publish()) {
+            readyFramesPending.fetch_sub(1, std::memory_order_relaxed);
+            readyFramesDropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        // replaced frame or frame uploaded by main thread, slot must be empty for next grab
+        framePool.release(ready.back().data);
+    }
+
+    // main thread took frame, it will be uploaded now
+    bool takeReadyFrame(LottieReadyFrames &ready) {
+        if (!ready.take()) {
+            return false;
+        }
+        readyFramesPending.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // frames of removed animation goes back to pool, called when other thread not use them
+    void releaseReadyFrames(LottieReadyFrames &ready) {
+        takeReadyFrame(ready);
+        for (ReadyFrame &frame : ready.slots) {
+            framePool.release(frame.data);
+        }
+    }
+
+    LottieQueueStats queueStats() const {
+        LottieQueueStats stats;
+        stats.commandsDepth = commands.size();
+        stats.readyFramesDepth = readyFramesPending.load(std::memory_order_relaxed);
+        stats.commandsOverflowed = commandsOverflowed.load(std::memory_order_relaxed);
+        stats.readyFramesDropped = readyFramesDropped.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    // resolve command in thread, because it can be added async from another thread
+    void resolveCommand(const LottieRenderCommand &cmd) {
+        switch (cmd.type) {
+        case LottieRenderCommand::ADD_CONFIG:
+        {
+            discardAnimation(cmd.pid);
+
+            LottieAnim anim;
+            LottieFrameSource *source = acquireSource(cmd.path.c_str(), cmd.w, cmd.h, cmd.rate);
+            bool loadOk = anim.load(source, cmd.path.c_str(), cmd.loop, true, 2, cmd.pid);
+            anim.readyFrames = cmd.readyFrames;
+            if (loadOk && anim.readyFrames) {
+                LottieAnimCold cold;
+                cold.lottiePath = cmd.path;
+                animations.insert(cmd.pid, std::move(anim), std::move(cold));
+                updateBakeRange(*source);
+            } else {
+                releaseSource(source);
+            }
+        } break;
+
+        case LottieRenderCommand::DISCARD_PID:
+        {
+            discardAnimation(cmd.pid);
+        } break;
+
+        case LottieRenderCommand::SETUP_PID:
+        {
+            const uint32_t propsHash = LottieAnim::getPropsHash(cmd.path.c_str(), cmd.w, cmd.h, cmd.loop, cmd.rate);
+            if (LottieAnim *anim = animations.findPid(propsHash)) {
+                if (propsHash != cmd.pid) {
+                    discardAnimation(cmd.pid);
+                    anim = animations.findPid(propsHash);
+                }
+                anim->pid = cmd.pid;
+                animations.rekey(propsHash, cmd.pid);
+            }
+        } break;
+
+        case LottieRenderCommand::SETUP_PLAY:
+        {
+            if (LottieAnim *anim = animations.findPid(cmd.pid)) {
+                anim->play = cmd.play;
+            }
+        } break;
+
+        case LottieRenderCommand::SETUP_RENDER:
+        {
+            if (LottieAnim *anim = animations.findPid(cmd.pid)) {
+                anim->renderonce = cmd.render;
+            }
+        } break;
+
+        case LottieRenderCommand::SUBMIT_BATCH:
+        {
+            for (size_t i = 0; i < cmd.pids.size(); ++i) {
+                if (LottieAnim *anim = animations.findPid(cmd.pids[i])) {
+                    anim->renderonce = true;
+                    anim->priority = i < cmd.priorities.size() ? cmd.priorities[i] : LottieAnim::DEFAULT_PRIORITY;
+                }
+            }
+        } break;
+
+        case LottieRenderCommand::SETUP_SUSPEND:
+        {
+            if (LottieAnim *anim = animations.findPid(cmd.pid)) {
+                anim->suspend(cmd.suspend, nowMs());
+            }
+        } break;
+
+        case LottieRenderCommand::SETUP_SEGMENT:
+        {
+            if (LottieAnim *anim = animations.findPid(cmd.pid)) {
+                anim->setSegment(cmd.path, cmd.startFrame, cmd.endFrame, cmd.loop != 0, framePool);
+                updateBakeRange(*anim->source);
+            }
+        } break;
+
+        case LottieRenderCommand::SETUP_SEEK:
+        {
+            if (LottieAnim *anim = animations.findPid(cmd.pid)) {
+                anim->seek(cmd.startFrame, framePool);
+            }
+        } break;
+
+        case LottieRenderCommand::SETUP_SPEED:
+        {
+            if (LottieAnim *anim = animations.findPid(cmd.pid)) {
+                anim->setSpeed(cmd.speed, nowMs());
+            }
+        } break;
+
+
+        default:
+        break;
+        }
+    }
+
+    void execute(int workersCount) {
+        workers.start(workersCount);
+        loader.onLoaded = [] (void *ctx) { ((LottieRenderThread *)ctx)->wakeup(); };
+        loader.onLoadedCtx = this;
+        loader.start(LottieLoader::DEFAULT_THREADS);
+
+        // popped command is swapped with slot, memory of its vectors goes back to producers
+        LottieRenderCommand cmd;
+        while (!terminating.load()) {
+            // resolve all commands came before this tick
+            while (popCommand(cmd)) {
+                resolveCommand(cmd);
+                // command goes back to queue slot, it must not keep frames of animation
+                cmd.readyFrames.reset();
+            }
+            resolveOverflowCommands();
+
+            applyLoadedModels();
+            requestEvictedModels();
+
+            if (animations.empty()) {
+                waitNextDeadline();
+                continue;
+            }
+
+            // every animation is one task, task own animation state while it rendered,
+            // so different animations can be rendered on different cores
+            const uint64_t tickTime = nowMs();
+            scheduleAnimations(tickTime);
+
+            // every task take next animation from schedule instead of its own index, so
+            // all workers go through schedule in deadline order
+            std::atomic<size_t> nextScheduled{0};
+            std::atomic<size_t> skippedTasks{0};
+            auto renderTask = [this, tickTime, &nextScheduled, &skippedTasks] (size_t) {
+                // frame render make a time, skip rest of tasks when thread want stop
+                if (terminating.load())
+                    return;
+
+                // tick is too long, rest of animations wait next tick, where most urgent go first again
+                const size_t position = nextScheduled.fetch_add(1);
+                if (position > 0 && nowMs() - tickTime > MAX_TICK_MS) {
+                    skippedTasks.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+
+                // prerender next frames and prepare copy data to current frame if need
+                const size_t index = schedule[position].index;
+                animations[index].render(tickTime, framePool, animations.cold(index));
+            };
+            const auto renderStart = std::chrono::steady_clock::now();
+            workers.parallelFor(schedule.size(), renderTask);
+            governor.busy_us += (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - renderStart).count();
+            governor.skippedTasks += skippedTasks.load(std::memory_order_relaxed);
+
+            // render animations and extract current animation frame to ready frames
+            for (LottieAnim &anim : animations) {
+                // if current frame ready, we need pass it to main thread, it will be copied to
+                // dynatlas on frame update from main thread, triple buffer is lock-free
+                // and frames only swapped with its slots
+                publishReadyFrame(anim);
+            }
+
+            enforceMemoryBudget();
+            publishAnimStats(tickTime);
+            updateQualityGovernor(nowMs());
 
-class LottieAnimationRenderer;
-namespace detail {
-    LottieAnimationRenderer *g_lottieRenderer = nullptr;
-}
+            waitNextDeadline();
+        }
 
-// This code defines a struct called LottieAnim, which represents a Lottie animation. It contains various static constants,
-// such as the default size and pre-rendered frames, as well as variables that store information about the animation
-// such as the timeline and frames.
-struct LottieAnim {
-    // default size for lottie renderer
-    static constexpr int DEFAULT_SIZE = 32;
-    // how many prerendered frames saved in array
-    static constexpr int DEFAULT_PRERENDERED_FRAMES = 2;
-    static constexpr int LOTTIE_SURFACE_FMT = sizeof(uint32_t); // TEXFMT_A8R8G8B8;
-    static constexpr int LOTTIE_SURFACE_FMT_BPP = sizeof(uint32_t);
+        loader.stop();
+        workers.stop();
+    }
 
-    // A unique identifier for the picture
-    ImGuiID pid = BAD_PICTUREID;
+    // counters of animations copied for main thread with this period
+    static constexpr uint32_t STATS_PERIOD_MS = 250;
+    std::mutex statsMutex;
+    std::vector<LottieAnimStats> animStats;
+    LottieMetrics metrics;
+    uint64_t statsPublished_ms = 0;
+    // counters of removed animations, they stay in totals
+    LottieFrameCounters retiredCounters;
+    std::vector<uint32_t> samples;
+    std::vector<uint32_t> allSamples;
 
-#ifdef IMLOTTIE_DX11_IMPLEMENTATION
-    // DirectX 11 implementation
-    ID3D11Texture2D* texture = nullptr;
-    ID3D11ShaderResourceView *srv = nullptr;
-#endif // IMLOTTIE_DX11_IMPLEMENTATION
-    struct {
-        int width = DEFAULT_SIZE;
-        int height = DEFAULT_SIZE;
-    } canvas;
+    void publishAnimStats(uint64_t tickTime) {
+        if (tickTime - statsPublished_ms < STATS_PERIOD_MS) {
+            return;
+        }
 
-    struct {
-        uint32_t duration_ms = 0;
-        uint32_t last_ms = 0;
-    } timeline;
+        statsPublished_ms = tickTime;
+        LottieFrameCounters total = retiredCounters;
+        allSamples.clear();
+        std::lock_guard<std::mutex> lock(statsMutex);
+        animStats.resize(animations.size());
+        for (size_t i = 0; i < animations.size(); ++i) {
+            const LottieAnim &anim = animations[i];
+            const LottieAnimCold &cold = animations.cold(i);
+            LottieAnimStats &stats = animStats[i];
+            stats.pid = anim.pid;
+            stats.priority = anim.priority;
+            stats.path = cold.lottiePath;
+            stats.width = anim.canvas.width;
+            stats.height = anim.canvas.height;
+            stats.frame = anim.frame.current;
+            stats.totalFrames = anim.source->total;
+            stats.baked = anim.source->isBaked(anim.segment.first);
+            stats.suspended = anim.suspended;
+            stats.framesShown = (uint32_t)cold.counters.shown;
+            stats.deadlineMisses = (uint32_t)cold.counters.misses;
+            stats.framesRendered = (uint32_t)cold.counters.rendered;
+            stats.framesReused = (uint32_t)cold.counters.reused();
+            stats.framesDropped = (uint32_t)cold.counters.dropped;
+            stats.framesSkipped = (uint32_t)cold.counters.skipped;
+
+            samples.clear();
+            cold.renderTimes.copyTo(samples);
+            allSamples.insert(allSamples.end(), samples.begin(), samples.end());
+            std::sort(samples.begin(), samples.end());
+            stats.renderUsP50 = LottieTimeSamples::percentile(samples, 0.5f);
+            stats.renderUsP99 = LottieTimeSamples::percentile(samples, 0.99f);
+            total.add(cold.counters);
+        }
+
+        std::sort(allSamples.begin(), allSamples.end());
+        metrics.animations = animations.size();
+        metrics.sources = sources.size();
+        metrics.framesShown = total.shown;
+        metrics.deadlineMisses = total.misses;
+        metrics.framesRendered = total.rendered;
+        metrics.framesDropped = total.dropped;
+        metrics.framesSkipped = total.skipped;
+        metrics.bakedHits = total.baked;
+        metrics.cacheHits = total.cached;
+        metrics.unchangedHits = total.unchanged;
+        metrics.reuseRate = total.rendered + total.reused() > 0 ? (float)total.reused() / (total.rendered + total.reused()) : 0.f;
+        metrics.renderUsP50 = LottieTimeSamples::percentile(allSamples, 0.5f);
+        metrics.renderUsP99 = LottieTimeSamples::percentile(allSamples, 0.99f);
+    }
+
+    void animationStats(std::vector<LottieAnimStats> &stats) {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        stats.assign(animStats.begin(), animStats.end());
+    }
+
+    // counters of render thread, queues, memory and quality
+    LottieMetrics renderMetrics() {
+        LottieMetrics m;
+        {
+            std::lock_guard<std::mutex> lock(statsMutex);
+            m = metrics;
+        }
+        m.queues = queueStats();
+        m.memory = memoryStats();
+        m.quality = qualityState();
+        return m;
+    }
+
+    // how long one tick can render, animations which not fit are rendered on next tick
+    static constexpr uint32_t MAX_TICK_MS = 8;
+
+    // Quality governor check load of thread every period. When thread busy most of time or
+    // tick has no time for all animations, quality reduced by one level, it restored after
+    // few calm periods. Levels: 1 - low priority animations play with half frame rate,
+    // 2 - canvases rendered at 3/4 of size, 3 - at 1/2 of size
+    static constexpr uint32_t GOVERNOR_PERIOD_MS = 500;
+    static constexpr float GOVERNOR_OVERLOAD = 0.75f;
+    static constexpr float GOVERNOR_UNDERLOAD = 0.35f;
+    static constexpr int GOVERNOR_RESTORE_PERIODS = 4;
+    static constexpr int QUALITY_HALF_RATE = 1;
+    static constexpr int QUALITY_MAX_LEVEL = 3;
 
+    // busy time measured by host clock, so with not realtime clock (manual stepping) load has
+    // no relation to clock time and level is frozen, else same steps give different frames
     struct {
-        uint16_t current = 0;
-        uint16_t total = 0;
-    } frame;
+        bool started = false;
+        uint64_t start_ms = 0;
+        uint64_t busy_us = 0;
+        size_t skippedTasks = 0;
+        int calmPeriods = 0;
+    } governor;
 
-    // Flags for the animation
-    bool loop = false;
-    bool play = false;
-    bool renderonce = false;
+    std::atomic<bool> governorEnabled{true};
+    std::atomic<int> qualityLevel{0};
+    std::atomic<float> qualityBusy{0.f};
+    std::atomic<uint64_t> qualityDegrades{0};
+    std::atomic<uint64_t> qualityRestores{0};
 
-    int maxPrerenderedFrames = DEFAULT_PRERENDERED_FRAMES;
-    std::string lottiePath;
+    static float canvasScale(int level) {
+        return level >= 3 ? 0.5f : (level >= 2 ? 0.75f : 1.f);
+    }
 
-    std::shared_ptr<imlottie::Animation> anim;
-    // we need save future frames, because are can have
-    // different time for render, thread render it on loop
-    std::queue<NextFrame> prerenderedFrames;
+    void updateQualityGovernor(uint64_t curTime) {
+        // first period starts from first tick, clock can start from any value
+        if (!governor.started) {
+            governor.started = true;
+            governor.start_ms = curTime;
+            governor.busy_us = 0;
+            governor.skippedTasks = 0;
+            return;
+        }
 
-    // here saved frame, which need for display, on every render()
-    // call prerendered frame will moved here when time for next frame gone
-    ReadyFrame currentFrame;
+        const uint64_t period = curTime - governor.start_ms;
+        if (period < GOVERNOR_PERIOD_MS) {
+            return;
+        }
 
-    // Grabs the current frame and stores it in the "f" parameter
-    bool grabCurrentFrame(ReadyFrame &f) {
-        if (currentFrame.pid == BAD_PICTUREID) {
-            return false;
+        const float busy = std::min(1.f, (float)((double)governor.busy_us / ((double)period * 1000.0)));
+        const bool overloaded = busy > GOVERNOR_OVERLOAD || governor.skippedTasks > 0;
+        const int level = qualityLevel.load(std::memory_order_relaxed);
+        int nextLevel = level;
+        if (!governorEnabled.load(std::memory_order_relaxed)) {
+            nextLevel = 0;
+        } else if (!clock->realtime()) {
+            governor.calmPeriods = 0;
+        } else if (overloaded) {
+            governor.calmPeriods = 0;
+            nextLevel = std::min(level + 1, QUALITY_MAX_LEVEL);
+        } else if (busy < GOVERNOR_UNDERLOAD && ++governor.calmPeriods >= GOVERNOR_RESTORE_PERIODS) {
+            governor.calmPeriods = 0;
+            nextLevel = std::max(level - 1, 0);
         }
 
-        std::swap(f, currentFrame);
-        return true;
+        governor.start_ms = curTime;
+        governor.busy_us = 0;
+        governor.skippedTasks = 0;
+        qualityBusy.store(busy, std::memory_order_relaxed);
+        if (nextLevel != level) {
+            (nextLevel > level ? qualityDegrades : qualityRestores).fetch_add(1, std::memory_order_relaxed);
+            qualityLevel.store(nextLevel, std::memory_order_relaxed);
+        }
+
+        // canvas size also applied to sources loaded after level changed
+        applyCanvasScale(canvasScale(nextLevel));
     }
 
-    // Returns a hash code based on the properties of the Lottie animation
-    static ImGuiID getPropsHash(const char *lottie, const int canvasWidth, const int canvasHeight, bool loop, int rate) {
-        char hash[512];
-        snprintf(hash, 511, "lottie:%s|canvasHeight:%d|canvasWidth:%d|loop:%d|rate:%d", lottie, canvasWidth, canvasHeight, loop, rate);
-        return ImHashStr(hash, 0, 0xc001f00d);
-        ;
+    void applyCanvasScale(float scale) {
+        bool changed = false;
+        for (auto &it : sources) {
+            changed |= it.second.rescale(scale);
+        }
+
+        if (changed) {
+            for (LottieAnim &anim : animations) {
+                anim.syncSource();
+            }
+        }
     }
 
-    // Loads the Lottie animation from the specified file path
-    bool load(const char *path, int w, int h, bool _loop, bool _play, int _prerenderedFrames, int rate, ImGuiID _pid) {
-        if (!path || 0 == *path) {
-            return false;
+    LottieQualityState qualityState() const {
+        LottieQualityState state;
+        state.enabled = governorEnabled.load(std::memory_order_relaxed);
+        state.level = qualityLevel.load(std::memory_order_relaxed);
+        state.canvasScale = canvasScale(state.level);
+        state.lowPriorityHalfRate = state.level >= QUALITY_HALF_RATE;
+        state.busy = qualityBusy.load(std::memory_order_relaxed);
+        state.degrades = qualityDegrades.load(std::memory_order_relaxed);
+        state.restores = qualityRestores.load(std::memory_order_relaxed);
+        return state;
+    }
+
+    struct Scheduled {
+        int32_t deadline;
+        uint32_t index;
+    };
+    std::vector<Scheduled> schedule;
+
+    // earliest deadline first, animations which need nothing on this tick not scheduled,
+    // priority moves deadline earlier
+    void scheduleAnimations(uint64_t tickTime) {
+        schedule.clear();
+        const bool halfRate = qualityLevel.load(std::memory_order_relaxed) >= QUALITY_HALF_RATE;
+        for (size_t i = 0; i < animations.size(); ++i) {
+            LottieAnim &anim = animations[i];
+            anim.frameStep = (halfRate && anim.priority <= 0) ? 2 : 1;
+
+            if (anim.nextDeadline(tickTime) > tickTime) {
+                continue;
+            }
+
+            const int32_t slack = int32_t(anim.scheduleDeadline(tickTime) - tickTime);
+            schedule.push_back({ slack - anim.priority * LottieAnim::PRIORITY_STEP_MS, (uint32_t)i });
         }
 
-        canvas.width = std::max<int>(w, DEFAULT_SIZE);
-        canvas.height = std::max<int>(h, DEFAULT_SIZE);
+        std::sort(schedule.begin(), schedule.end(), [] (const Scheduled &a, const Scheduled &b) {
+            return a.deadline < b.deadline;
+        });
+    }
 
-        loop = _loop;
-        play = _play;
-        pid = _pid;
-        maxPrerenderedFrames = std::max<int>(_prerenderedFrames, DEFAULT_PRERENDERED_FRAMES);
+    // sleep until earliest frame deadline, without animations sleep until new command
+    void waitNextDeadline() {
+        const uint64_t now = nowMs();
+        uint64_t deadline = LottieAnim::NO_DEADLINE;
+        for (LottieAnim &anim : animations) {
+            deadline = std::min(deadline, anim.nextDeadline(now));
+        }
 
-        lottiePath = path;
-        anim = imlottie::animationLoad(path);
+        // spend time before deadline to bake frames of small animations
+        while (deadline > nowMs() + BAKE_SLACK_MS && !hasCommands() && !loader.hasResults() && !terminating.load() && bakeStep()) {
+        }
 
-        if (anim) {
-            int customRate = rate;
-            frame.total = (uint16_t)imlottie::animationTotalFrame(anim);
-            float oneFrameMs = (float)imlottie::animationDuration(anim) / frame.total;
-            timeline.duration_ms = int(customRate > 0 ? 1000 / customRate : oneFrameMs * 1000);
-        } else {
-            printf("Lottie::animation load failed from <%s>", path);
-            return false;
+        if (deadline <= nowMs()) {
+            return;
         }
 
-        return true;
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        sleepDeadline_ms = deadline;
+        idleCondition.notify_all();
+
+        auto awake = [this, deadline] () { return terminating.load() || hasCommands() || loader.hasResults() || nowMs() >= deadline; };
+        if (deadline == LottieAnim::NO_DEADLINE || !clock->realtime()) {
+            wakeCondition.wait(lock, awake);
+        } else {
+            wakeCondition.wait_for(lock, std::chrono::milliseconds(deadline - std::min(deadline, nowMs())), awake);
+        }
+        sleeping.store(false, std::memory_order_relaxed);
     }
+};
 
-    bool render(uint32_t curTime) {
-        if (pid == BAD_PICTUREID || !(play || renderonce))
-            return false;
+// Place of animation frame in atlas page
+struct LottieAtlasSlot {
+    int page = -1;
+    int x = 0, y = 0, w = 0, h = 0;
+    ImVec2 uv0 = ImVec2(0, 0);
+    ImVec2 uv1 = ImVec2(1, 1);
+    // padding can keep pixels of previous slot in same place, cleared with first upload
+    bool clearPadding = false;
 
-        renderonce = false;
-        if (!loop && frame.current > frame.total)
-            return false;
+    bool valid() const { return page >= 0; }
+};
+
+// Shelf packer for one atlas page. Page splitted to horizontal shelves, every shelf
+// filled by slots from left to right. Free slots are merged with free neighbours and
+// reused by frames with similar height, empty shelves on top of page are removed
+struct LottieShelfPacker {
+    struct Span {
+        int x, w;
+        bool used;
+    };
+
+    struct Shelf {
+        int y, h;
+        std::vector<Span> spans;
+    };
+
+    int width = 0;
+    int height = 0;
+    int nextY = 0;
+    int usedSlots = 0;
+    std::vector<Shelf> shelves;
 
-        uint32_t frameDiff = (curTime - timeline.last_ms) / timeline.duration_ms;
-        if (frameDiff != 0) {
-            // move first of prerendered frames to readyFrame, main thread
-            // after render it will be move to readFrames array
-            if (prerenderedFrames.size() > 0) {
-                // move the first pre-rendered frame to the current frame
-                NextFrame nextFrame;
-                std::swap(nextFrame, prerenderedFrames.front());
-                prerenderedFrames.pop();
-                std::swap(currentFrame.data, nextFrame.data);
-                currentFrame.size = nextFrame.size;
-                currentFrame.pid = pid;
-#if DEBUG_LOTTIE_UPDATE
-                // for debugging purposes, set the lottie path, current frame and duration
-                currentFrame.lottie = lottiePath.c_str();
-                currentFrame.frame = frame.current;
-                currentFrame.duration_ms = timeline.duration_ms;
-#endif // DEBUG_LOTTIE_UPDATE
+    void reset(int w, int h) {
+        width = w;
+        height = h;
+        nextY = 0;
+        usedSlots = 0;
+        shelves.clear();
+    }
+
+    bool insert(Shelf &shelf, int w, int &x) {
+        for (size_t i = 0; i < shelf.spans.size(); ++i) {
+            Span &span = shelf.spans[i];
+            if (span.used || span.w < w) {
+                continue;
             }
 
-            // switch to next frame index
-            frame.current++;
-            if (loop) {
-                frame.current %= frame.total;
+            x = span.x;
+            if (span.w > w) {
+                shelf.spans.insert(shelf.spans.begin() + i + 1, Span{span.x + w, span.w - w, false});
             }
-            timeline.last_ms += frameDiff * timeline.duration_ms;
+            shelf.spans[i].w = w;
+            shelf.spans[i].used = true;
+            usedSlots++;
+            return true;
         }
+        return false;
+    }
 
-        if (prerenderedFrames.size() <= std::max<int>(maxPrerenderedFrames, DEFAULT_PRERENDERED_FRAMES)) {
-            // calc next prerendered frame index
-            uint16_t nextFrameIndex = frame.current + (uint16_t)prerenderedFrames.size();
+    bool alloc(int w, int h, int &x, int &y) {
+        if (w > width || h > height) {
+            return false;
+        }
 
-            // if loop we need back to 0 and render again
-            if (loop) {
-                nextFrameIndex = (nextFrameIndex % frame.total);
+        // shelves with near height first, that not waste space of tall shelves
+        for (int pass = 0; pass < 2; ++pass) {
+            for (auto &shelf : shelves) {
+                const bool fits = pass == 0 ? (shelf.h >= h && shelf.h <= h + h / 2) : shelf.h >= h;
+                if (fits && insert(shelf, w, x)) {
+                    y = shelf.y;
+                    return true;
+                }
             }
+        }
+
+        if (nextY + h > height) {
+            return false;
+        }
 
-            // not need prerender frames when all finished
-            if (nextFrameIndex < frame.total) {
-                // create new frame
-                prerenderedFrames.push({});
-                NextFrame &nextFrame = prerenderedFrames.back();
+        shelves.push_back({nextY, h, {{0, width, false}}});
+        nextY += h;
+        y = shelves.back().y;
+        return insert(shelves.back(), w, x);
+    }
 
-                // size for next frame memory
-                size_t bufferSize = canvas.width * canvas.height * LOTTIE_SURFACE_FMT_BPP;
+    void free(int x, int y) {
+        auto shelf = std::find_if(shelves.begin(), shelves.end(), [y] (auto &s) { return s.y == y; });
+        if (shelf == shelves.end()) {
+            return;
+        }
 
-                // create memory block where will be placed frame
-                nextFrame.data.resize(bufferSize);
+        auto &spans = shelf->spans;
+        auto span = std::find_if(spans.begin(), spans.end(), [x] (auto &s) { return s.x == x && s.used; });
+        if (span == spans.end()) {
+            return;
+        }
 
-                // save frame size for next actions
-                nextFrame.size = ImVec2((float)canvas.width, (float)canvas.height);
+        span->used = false;
+        usedSlots--;
+        size_t i = span - spans.begin();
+        if (i + 1 < spans.size() && !spans[i + 1].used) {
+            spans[i].w += spans[i + 1].w;
+            spans.erase(spans.begin() + i + 1);
+        }
+        if (i > 0 && !spans[i - 1].used) {
+            spans[i - 1].w += spans[i].w;
+            spans.erase(spans.begin() + i);
+        }
 
-                imlottie::animationRenderSync(anim, nextFrameIndex, (uint32_t *)nextFrame.data.data(), canvas.width, canvas.height, canvas.width *LOTTIE_SURFACE_FMT_BPP);
-                return true;
-            }
+        // give space of empty top shelves back to page
+        while (!shelves.empty() && shelves.back().spans.size() == 1 && !shelves.back().spans[0].used) {
+            nextY = shelves.back().y;
+            shelves.pop_back();
         }
+    }
+};
 
-        return false;
-}
+// Interface for texture storage of atlas pages, frontend not depend on graphics api and
+// call backend only from main thread inside sync(). Pixels are premultiplied BGRA, 4 bytes
+// per pixel. Texture handle returned by createTexture() is used as ImTextureID.
+struct LottieTextureBackend {
+    virtual ~LottieTextureBackend() = default;
+
+    // create texture filled with transparent pixels, returns null on failure
+    virtual void *createTexture(int width, int height) = 0;
+    // copy pixels to region of texture, pitch is bytes per row of data
+    virtual bool updateTexture(void *texture, int x, int y, int width, int height, const uint8_t *data, int pitch) = 0;
+    virtual void destroyTexture(void *texture) = 0;
+
+    // Backend can lend memory for frames, for example mapped staging texture or upload ring,
+    // render thread draws frames directly there. Returns memory with pitch bytes per row and
+    // handle of it, null when backend not lend memory. Memory stays writable until reclaimed
+    virtual uint8_t *lendBuffer(int /*width*/, int /*height*/, int &/*pitch*/, void *&/*handle*/) { return nullptr; }
+    // copy region of lent buffer from srcX, srcY to texture, false when it must be uploaded by updateTexture()
+    virtual bool commitBuffer(void * /*texture*/, int /*x*/, int /*y*/, int /*width*/, int /*height*/, void * /*handle*/, int /*srcX*/, int /*srcY*/) { return false; }
+    // lent memory not used by frontend anymore, memory still lent on destroy is freed by backend
+    virtual void reclaimBuffer(void * /*handle*/) {}
+};
 
-    // Simple helper function to load an image into a DX11 texture with common settings
 #ifdef IMLOTTIE_DX11_IMPLEMENTATION
-    bool createTextureFromData(uint8_t *image_data, ::ID3D11Device* pd3dDevice) {
-        if (image_data == NULL) {
-            return false;
+// DirectX 11 backend, device and context are set from sync(device, context)
+struct LottieDX11Backend : LottieTextureBackend {
+    ::ID3D11Device *device = nullptr;
+    ID3D11DeviceContext *ctx = nullptr;
+    // texture for shader resource view, view is handle for imgui
+    std::unordered_map<void *, ID3D11Texture2D *> textures;
+
+    void *createTexture(int width, int height) override {
+        if (!device) {
+            return nullptr;
         }
 
-        // Create texture
         D3D11_TEXTURE2D_DESC desc;
         ZeroMemory(&desc, sizeof(desc));
-        desc.Width = canvas.width;
-        desc.Height = canvas.height;
+        desc.Width = width;
+        desc.Height = height;
         desc.MipLevels = 1;
         desc.ArraySize = 1;
         desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
         desc.SampleDesc.Count = 1;
+        // texture updated by parts, so it can't be dynamic texture with discard on map
         desc.Usage = D3D11_USAGE_DEFAULT;
         desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-        desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-        desc.Usage = D3D11_USAGE_DYNAMIC;
 
+        std::vector<uint8_t> zero(desc.Width * desc.Height * 4, 0);
         D3D11_SUBRESOURCE_DATA subResource;
-        subResource.pSysMem = image_data;
+        subResource.pSysMem = zero.data();
         subResource.SysMemPitch = desc.Width * 4;
         subResource.SysMemSlicePitch = 0;
-        pd3dDevice->CreateTexture2D(&desc, &subResource, &texture);
+        ID3D11Texture2D *texture = nullptr;
+        if (FAILED(device->CreateTexture2D(&desc, &subResource, &texture))) {
+            return nullptr;
+        }
 
-        // Create texture view
         D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
         ZeroMemory(&srvDesc, sizeof(srvDesc));
         srvDesc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
         srvDesc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
         srvDesc.Texture2D.MipLevels = desc.MipLevels;
         srvDesc.Texture2D.MostDetailedMip = 0;
-        pd3dDevice->CreateShaderResourceView(texture, &srvDesc, &srv);
-        //pTexture->Release();
-        return true;
+        ID3D11ShaderResourceView *srv = nullptr;
+        if (FAILED(device->CreateShaderResourceView(texture, &srvDesc, &srv))) {
+            texture->Release();
+            return nullptr;
+        }
+
+        textures[srv] = texture;
+        return srv;
     }
 
-    bool updateTextureFromData(unsigned char* image_data, ID3D11DeviceContext* ctx) {
-        if (!image_data) {
+    bool updateTexture(void *texture, int x, int y, int width, int height, const uint8_t *data, int pitch) override {
+        auto it = textures.find(texture);
+        if (it == textures.end() || !ctx) {
             return false;
         }
 
-        D3D11_MAPPED_SUBRESOURCE ms;
-        HRESULT hr = ctx->Map(texture, 0, D3D11_MAP_WRITE_DISCARD, 0, &ms);
-        if (FAILED(hr)) {
-            return false;
+        D3D11_BOX box;
+        box.left = x;
+        box.top = y;
+        box.front = 0;
+        box.right = x + width;
+        box.bottom = y + height;
+        box.back = 1;
+        ctx->UpdateSubresource(it->second, 0, &box, data, pitch, 0);
+        return true;
+    }
+
+    void destroyTexture(void *texture) override {
+        auto it = textures.find(texture);
+        if (it == textures.end()) {
+            return;
+        }
+
+        ((ID3D11ShaderResourceView *)texture)->Release();
+        it->second->Release();
+        textures.erase(it);
+    }
+
+    // staging textures lent mapped, frames rendered to them are copied to atlas by gpu
+    static constexpr size_t MAX_FREE_STAGING = 16;
+    struct Staging {
+        ID3D11Texture2D *texture = nullptr;
+        int width = 0;
+        int height = 0;
+        bool mapped = false;
+    };
+    std::unordered_map<void *, Staging> lent;
+    std::vector<Staging> freeStaging;
+
+    ~LottieDX11Backend() {
+        for (auto &it : lent) {
+            freeStaging.push_back(it.second);
+        }
+        for (Staging &staging : freeStaging) {
+            if (staging.mapped && ctx) {
+                ctx->Unmap(staging.texture, 0);
+            }
+            staging.texture->Release();
+        }
+    }
+
+    uint8_t *lendBuffer(int width, int height, int &pitch, void *&handle) override {
+        if (!device || !ctx) {
+            return nullptr;
+        }
+
+        Staging staging;
+        auto it = std::find_if(freeStaging.begin(), freeStaging.end(), [=] (const Staging &s) { return s.width == width && s.height == height; });
+        if (it != freeStaging.end()) {
+            staging = *it;
+            freeStaging.erase(it);
+        } else {
+            D3D11_TEXTURE2D_DESC desc;
+            ZeroMemory(&desc, sizeof(desc));
+            desc.Width = width;
+            desc.Height = height;
+            desc.MipLevels = 1;
+            desc.ArraySize = 1;
+            desc.Format = DXGI_FORMAT_B8G8R8A8_UNORM;
+            desc.SampleDesc.Count = 1;
+            desc.Usage = D3D11_USAGE_STAGING;
+            desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+            if (FAILED(device->CreateTexture2D(&desc, nullptr, &staging.texture))) {
+                return nullptr;
+            }
+            staging.width = width;
+            staging.height = height;
+        }
+
+        // staging can be still copied by gpu, frame goes to own memory then
+        D3D11_MAPPED_SUBRESOURCE mapped;
+        if (FAILED(ctx->Map(staging.texture, 0, D3D11_MAP_WRITE, D3D11_MAP_FLAG_DO_NOT_WAIT, &mapped))) {
+            freeStaging.push_back(staging);
+            return nullptr;
         }
 
-        const uint8_t* src = image_data;
-        uint8_t* dst = (uint8_t*)ms.pData;
+        staging.mapped = true;
+        handle = staging.texture;
+        lent[handle] = staging;
+        pitch = (int)mapped.RowPitch;
+        return (uint8_t *)mapped.pData;
+    }
+
+    bool commitBuffer(void *texture, int x, int y, int width, int height, void *handle, int srcX, int srcY) override {
+        auto it = textures.find(texture);
+        auto staging = lent.find(handle);
+        if (it == textures.end() || staging == lent.end() || !ctx) {
+            return false;
+        }
 
-        uint32_t bytes_per_row = canvas.width * 4;
-        for (int y = 0; y < canvas.height; ++y) {
-            memcpy(dst, src, bytes_per_row);
-            src += bytes_per_row;
-            dst += ms.RowPitch;
+        if (staging->second.mapped) {
+            ctx->Unmap(staging->second.texture, 0);
+            staging->second.mapped = false;
         }
 
-        ctx->Unmap(texture, 0);
+        D3D11_BOX box;
+        box.left = srcX;
+        box.top = srcY;
+        box.front = 0;
+        box.right = srcX + width;
+        box.bottom = srcY + height;
+        box.back = 1;
+        ctx->CopySubresourceRegion(it->second, 0, x, y, 0, staging->second.texture, 0, &box);
         return true;
     }
-#endif // IMLOTTIE_DX11_IMPLEMENTATION
+
+    void reclaimBuffer(void *handle) override {
+        auto it = lent.find(handle);
+        if (it == lent.end()) {
+            return;
+        }
+
+        Staging staging = it->second;
+        lent.erase(it);
+        if (staging.mapped && ctx) {
+            ctx->Unmap(staging.texture, 0);
+            staging.mapped = false;
+        }
+        if (freeStaging.size() < MAX_FREE_STAGING) {
+            freeStaging.push_back(staging);
+        } else {
+            staging.texture->Release();
+        }
+    }
 };
+#endif // IMLOTTIE_DX11_IMPLEMENTATION
 
-struct LottieRenderCommand {
-    enum Type { UNKNOWN = 0, ADD_CONFIG, DISCARD_PID, SETUP_PID, SETUP_PLAY, SETUP_RENDER };
-    Type type;
-    std::string path;
-    int w, h;
-    int loop;
-    int rate;
-    ImGuiID pid;
-    bool play;
-    bool render;
+#ifdef IMLOTTIE_OPENGL_IMPLEMENTATION
+// OpenGL backend, GL headers and loader must be included before imlottie.h
+struct LottieOpenGLBackend : LottieTextureBackend {
+    void *createTexture(int width, int height) override {
+        GLint lastTexture = 0;
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &lastTexture);
+
+        std::vector<uint8_t> zero(width * height * 4, 0);
+        GLuint texture = 0;
+        glGenTextures(1, &texture);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_BGRA, GL_UNSIGNED_BYTE, zero.data());
+
+        glBindTexture(GL_TEXTURE_2D, lastTexture);
+        return (void *)(intptr_t)texture;
+    }
+
+    bool updateTexture(void *texture, int x, int y, int width, int height, const uint8_t *data, int pitch) override {
+        GLint lastTexture = 0;
+        glGetIntegerv(GL_TEXTURE_BINDING_2D, &lastTexture);
+
+        glBindTexture(GL_TEXTURE_2D, (GLuint)(intptr_t)texture);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, pitch / 4);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_BGRA, GL_UNSIGNED_BYTE, data);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+        glBindTexture(GL_TEXTURE_2D, lastTexture);
+        return true;
+    }
+
+    void destroyTexture(void *texture) override {
+        GLuint id = (GLuint)(intptr_t)texture;
+        glDeleteTextures(1, &id);
+    }
 };
+#endif // IMLOTTIE_OPENGL_IMPLEMENTATION
 
-// this thread resolve command to load lotti animations, and their render frames
-struct LottieRenderThread {
-    std::atomic_int terminating = false;
-    bool popCommand(LottieRenderCommand &command) {
-        std::lock_guard<std::mutex> lock(commandsMutex);
-        if (commands.empty())
+// Backend which keep textures in system memory, it works without gpu, so whole frontend
+// can be run in headless tests and upload cost measured on any platform
+struct LottieMemoryBackend : LottieTextureBackend {
+    struct Texture {
+        int width = 0;
+        int height = 0;
+        std::vector<uint8_t> pixels;
+    };
+
+    std::vector<std::unique_ptr<Texture>> textures;
+    uint64_t uploads = 0;
+    uint64_t uploadBytes = 0;
+    uint64_t uploadTimeUs = 0;
+
+    // lend buffers with padded rows like gpu backend, so zero-copy path can be tested headless
+    bool lending = false;
+    static constexpr int LEND_PITCH_ALIGN = 256;
+    struct LentBuffer {
+        std::vector<uint8_t> pixels;
+        int pitch = 0;
+    };
+    std::unordered_map<void *, std::unique_ptr<LentBuffer>> lent;
+    uint64_t lends = 0;
+
+    void *createTexture(int width, int height) override {
+        textures.emplace_back(new Texture);
+        Texture &texture = *textures.back();
+        texture.width = width;
+        texture.height = height;
+        texture.pixels.assign(width * height * 4, 0);
+        return &texture;
+    }
+
+    bool updateTexture(void *handle, int x, int y, int width, int height, const uint8_t *data, int pitch) override {
+        Texture *texture = find(handle);
+        if (!texture || x + width > texture->width || y + height > texture->height) {
             return false;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        const int dstPitch = texture->width * 4;
+        uint8_t *dst = texture->pixels.data() + y * dstPitch + x * 4;
+        for (int row = 0; row < height; ++row) {
+            memcpy(dst, data, width * 4);
+            data += pitch;
+            dst += dstPitch;
+        }
 
-        std::swap(command, commands.front());
-        commands.pop();
+        uploads++;
+        uploadBytes += (uint64_t)width * height * 4;
+        uploadTimeUs += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
         return true;
     }
 
-    void addCommand(const LottieRenderCommand &command) {
-        if (commands.size() > 100) {
-            return;
+    uint8_t *lendBuffer(int width, int height, int &pitch, void *&handle) override {
+        if (!lending) {
+            return nullptr;
         }
-        std::lock_guard<std::mutex> lock(commandsMutex);
-        commands.push(command);
+
+        pitch = (width * 4 + LEND_PITCH_ALIGN - 1) / LEND_PITCH_ALIGN * LEND_PITCH_ALIGN;
+        std::unique_ptr<LentBuffer> buffer(new LentBuffer);
+        buffer->pixels.resize((size_t)pitch * height);
+        buffer->pitch = pitch;
+        handle = buffer.get();
+        uint8_t *pixels = buffer->pixels.data();
+        lent[handle] = std::move(buffer);
+        lends++;
+        return pixels;
     }
 
-    std::thread independentThread;
-    std::unordered_map<uint32_t, LottieAnim> animations;
+    bool commitBuffer(void *handle, int x, int y, int width, int height, void *buffer, int srcX, int srcY) override {
+        auto it = lent.find(buffer);
+        if (it == lent.end()) {
+            return false;
+        }
 
-    // this queue contain commands for animations
-    // load - load animation may take much time
-    // discard - after reset\remove image in PM we need remove it from quese
-    //           because PM cant contain real image for it
-    // setup pid - animation need assign PictureID in PM, this pid
-    //             received later than load, when we have area in atlas for image
-    // setup play flag - for future, when we need change play status
-    std::mutex commandsMutex;
-    std::queue<LottieRenderCommand> commands;
+        const LentBuffer &src = *it->second;
+        return updateTexture(handle, x, y, width, height, src.pixels.data() + (size_t)srcY * src.pitch + srcX * 4, src.pitch);
+    }
 
-    // this queue contain ready frames from animations, it placed in system
-    // memory that another thread can copy their to PM texture later
-    std::mutex readyFramesMutex;
-    std::queue<ReadyFrame> readyFrames;
-    float curtime = 0;
+    void reclaimBuffer(void *handle) override {
+        lent.erase(handle);
+    }
 
-    void pushReadyFrame(ReadyFrame &frame, size_t maxAnimSize) {
-        std::lock_guard<std::mutex> lock(readyFramesMutex);
-        // remove extra frames, that avoid creating infinite queue
-        if (readyFrames.size() > maxAnimSize)
-            readyFrames.pop();
+    void destroyTexture(void *handle) override {
+        textures.erase(std::remove_if(textures.begin(), textures.end(), [handle] (auto &t) { return t.get() == handle; }), textures.end());
+    }
 
-        readyFrames.push({});
-        std::swap(readyFrames.back(), frame);
+    Texture *find(void *handle) {
+        auto it = std::find_if(textures.begin(), textures.end(), [handle] (auto &t) { return t.get() == handle; });
+        return it == textures.end() ? nullptr : it->get();
     }
+};
+
+// Shared dynamic atlas for frames of all animations, every animation take slot in one
+// of pages and widgets draw it with slot uv, so imgui can batch all lottie widgets from
+// the same page. Only slots of animations with new frames are updated on sync()
+struct LottieAtlas {
+    static constexpr int PAGE_SIZE = 1024;
+    // free pixels around slot, that texture filtering not take pixels of neighbours
+    static constexpr int PADDING = 1;
+
+    struct Page {
+        LottieShelfPacker packer;
+        // backend texture, created on first upload
+        void *texture = nullptr;
+    };
+
+    std::vector<std::unique_ptr<Page>> pages;
+    // textures of emptied pages, draw list of imgui frame where page emptied can still use
+    // them, so they destroyed on sync of later frame after that draw data rendered
+    struct RetiredTexture {
+        void *texture = nullptr;
+        int frame = 0;
+    };
+    std::vector<RetiredTexture> retired;
+    // updates of slots and their pixels, for telemetry
+    uint64_t uploads = 0;
+    uint64_t uploadBytes = 0;
+    // transparent pixels for padding of reused places
+    std::vector<uint8_t> zeros;
+
+    bool alloc(int w, int h, LottieAtlasSlot &slot) {
+        const int pw = w + PADDING * 2;
+        const int ph = h + PADDING * 2;
+        int x = 0, y = 0;
+        for (size_t i = 0; i < pages.size(); ++i) {
+            if (pages[i]->packer.alloc(pw, ph, x, y)) {
+                return assign(slot, (int)i, x, y, w, h);
+            }
+        }
 
-    bool popReadyFrame(ReadyFrame &frame) {
-        std::lock_guard<std::mutex> lock(readyFramesMutex);
-        if (readyFrames.empty())
+        // big frames will have own page
+        pages.emplace_back(new Page);
+        pages.back()->packer.reset(std::max(PAGE_SIZE, pw), std::max(PAGE_SIZE, ph));
+        if (!pages.back()->packer.alloc(pw, ph, x, y)) {
             return false;
+        }
+        return assign(slot, (int)pages.size() - 1, x, y, w, h);
+    }
 
-        std::swap(frame, readyFrames.front());
-        readyFrames.pop();
+    bool assign(LottieAtlasSlot &slot, int page, int x, int y, int w, int h) {
+        const LottieShelfPacker &packer = pages[page]->packer;
+        slot.page = page;
+        slot.x = x + PADDING;
+        slot.y = y + PADDING;
+        slot.w = w;
+        slot.h = h;
+        slot.uv0 = ImVec2((float)slot.x / packer.width, (float)slot.y / packer.height);
+        slot.uv1 = ImVec2((float)(slot.x + w) / packer.width, (float)(slot.y + h) / packer.height);
+        // texture of new page is transparent, place on old page can have pixels of freed slot
+        slot.clearPadding = pages[page]->texture != nullptr;
         return true;
     }
 
-    // resolve command in thread, because it can be added async from another thread
-    void resolveCommand(const LottieRenderCommand &cmd) {
-        switch (cmd.type) {
-        case LottieRenderCommand::ADD_CONFIG:
-        {
-            LottieAnim anim;
-            bool loadOk = anim.load(cmd.path.c_str(), cmd.w, cmd.h, cmd.loop, true, 2, cmd.rate, cmd.pid);
-            if (loadOk) {
-                animations.insert({cmd.pid, std::move(anim)});
-            }
-        } break;
-
-        case LottieRenderCommand::DISCARD_PID:
-        {
-            auto it = std::find_if( animations.begin(), animations.end(), [pid = cmd.pid](auto &a) { return a.second.pid == pid; });
-            if (it != animations.end())
-                animations.erase(it);
-        } break;
+    void free(LottieAtlasSlot &slot) {
+        if (slot.valid() && slot.page < (int)pages.size()) {
+            pages[slot.page]->packer.free(slot.x - PADDING, slot.y - PADDING);
+        }
+        slot = LottieAtlasSlot();
+    }
 
-        case LottieRenderCommand::SETUP_PID:
-        {
-            const uint32_t propsHash = LottieAnim::getPropsHash(cmd.path.c_str(), cmd.w, cmd.h, cmd.loop, cmd.rate);
-            auto it = animations.find(propsHash);
-            if (it != animations.end()) {
-                it->second.pid = cmd.pid;
-            }
-        } break;
+    // texture filtering reads padding around slot when frame scaled, it must be transparent
+    bool clearPadding(void *texture, const LottieAtlasSlot &slot, LottieTextureBackend &backend) {
+        const int x = slot.x - PADDING;
+        const int y = slot.y - PADDING;
+        const int w = slot.w + PADDING * 2;
+        const int h = slot.h + PADDING * 2;
+        zeros.resize((size_t)std::max(w, h) * PADDING * 4);
+        const bool cleared = backend.updateTexture(texture, x, y, w, PADDING, zeros.data(), w * 4)
+                          && backend.updateTexture(texture, x, slot.y + slot.h, w, PADDING, zeros.data(), w * 4)
+                          && backend.updateTexture(texture, x, slot.y, PADDING, slot.h, zeros.data(), PADDING * 4)
+                          && backend.updateTexture(texture, slot.x + slot.w, slot.y, PADDING, slot.h, zeros.data(), PADDING * 4);
+        if (cleared) {
+            uploadBytes += ((uint64_t)w + slot.h) * PADDING * 2 * 4;
+        }
+        return cleared;
+    }
 
-        case LottieRenderCommand::SETUP_PLAY:
-        {
-            auto it = std::find_if( animations.begin(), animations.end(), [pid = cmd.pid](auto &a) { return a.second.pid == pid; });
-            if (it != animations.end()) {
-                it->second.play = cmd.play;
+    // copy area of frame to its slot, returns page texture
+    void *upload(LottieAtlasSlot &slot, const LottieFrameBuffer &frame, LottieRect rect, LottieTextureBackend &backend) {
+        if (!slot.valid() || frame.empty()) {
+            return nullptr;
+        }
+
+        Page &page = *pages[slot.page];
+        if (!page.texture) {
+            page.texture = backend.createTexture(page.packer.width, page.packer.height);
+            if (!page.texture) {
+                return nullptr;
             }
-        } break;
+            // new page has nothing of previous frames
+            rect = LottieRect::sized(0, 0, slot.w, slot.h);
+            slot.clearPadding = false;
+        }
 
-        case LottieRenderCommand::SETUP_RENDER:
-        {
-            auto it = std::find_if( animations.begin(), animations.end(), [pid = cmd.pid](auto &a) { return a.second.pid == pid; });
-            if (it != animations.end()) {
-                it->second.renderonce = cmd.render;
+        if (slot.clearPadding) {
+            if (!clearPadding(page.texture, slot, backend)) {
+                return nullptr;
             }
-        } break;
+            slot.clearPadding = false;
+        }
 
+        // only changed part of slot updated, other part of page not touched
+        rect.clip(slot.w, slot.h);
+        if (rect.empty()) {
+            return page.texture;
+        }
 
-        default:
-        break;
+        // frame in lent memory copied by backend itself
+        const int x = slot.x + rect.x0;
+        const int y = slot.y + rect.y0;
+        const bool committed = frame.lent && backend.commitBuffer(page.texture, x, y, rect.width(), rect.height(), frame.lent, rect.x0, rect.y0);
+        if (!committed) {
+            const uint8_t *pixels = frame.data() + (size_t)rect.y0 * frame.pitch + rect.x0 * 4;
+            if (!backend.updateTexture(page.texture, x, y, rect.width(), rect.height(), pixels, frame.pitch)) {
+                return nullptr;
+            }
         }
+
+        uploads++;
+        uploadBytes += (uint64_t)rect.width() * rect.height() * 4;
+        return page.texture;
     }
 
-    void execute() {
-        while (!terminating.load()) {
-            LottieRenderCommand cmd;
-            if (popCommand(cmd)) {
-                resolveCommand(cmd);
+    // textures of pages without slots are retired in imgui frame, empty pages on end removed
+    void trim(LottieTextureBackend *backend, int frame) {
+        size_t kept = 0;
+        for (const RetiredTexture &it : retired) {
+            if (it.frame != frame) {
+                if (backend) {
+                    backend->destroyTexture(it.texture);
+                }
+            } else {
+                retired[kept++] = it;
             }
+        }
+        retired.resize(kept);
 
-            if (animations.empty()) {
-                std::this_thread::sleep_for(std::chrono::milliseconds(100));
-                continue;
+        for (auto &page : pages) {
+            if (page->packer.usedSlots == 0 && page->texture) {
+                retired.push_back({ page->texture, frame });
+                page->texture = nullptr;
+                page->packer.reset(PAGE_SIZE, PAGE_SIZE);
             }
+        }
 
-            // render animations and extract current animation frame to ready frames array
-            const size_t maxAnimSize = animations.size() * 2;
-            for (auto &anim : animations) {
-                // it's loop here for all animations and frame render make a time, break
-                // it when thread want stop
-                if (terminating.load())
-                    return;
+        while (!pages.empty() && pages.back()->packer.usedSlots == 0) {
+            pages.pop_back();
+        }
+    }
 
-                // prerender next frames and prepare copy data to current frame if need
-                anim.second.render((uint32_t)curtime);
-
-                // if current frame ready, we need copy it to ready frames array
-                // ready frames array will be copied to dynatlas on frame update from
-                // main thread so we need use mutex for guard access when array changes
-                ReadyFrame currentFrame;
-                if (anim.second.grabCurrentFrame(currentFrame)) {
-                    pushReadyFrame(currentFrame, maxAnimSize);
-                }
+    void release(LottieTextureBackend *backend) {
+        for (auto &page : pages) {
+            if (page->texture && backend) {
+                backend->destroyTexture(page->texture);
+            }
+        }
+        pages.clear();
+
+        for (const RetiredTexture &it : retired) {
+            if (backend) {
+                backend->destroyTexture(it.texture);
             }
         }
+        retired.clear();
     }
 };
 
@@ -465,29 +3322,118 @@ struct LottieAnimDesc {
     ImVec2 size;
     void *srv = nullptr;
     ImGuiID pid = BAD_PICTUREID;
+    // where animation frames placed in atlas
+    LottieAtlasSlot slot;
+    // version of frame in slot, frames based on it update only damaged area
+    uint32_t version = 0;
+    // last imgui frame when widget with this animation was drawn
+    int lastSeenFrame = 0;
+    int submittedFrame = -1;
+    // place in batch of current frame
+    size_t submittedIndex = 0;
+    bool suspended = false;
+    // bytes copied to atlas for this animation
+    uint64_t uploadBytes = 0;
+    // newest frame rendered for animation, main thread is only consumer
+    std::shared_ptr<LottieReadyFrames> readyFrames;
+    // imgui frame when slot got last frame, when upload budget is short longest waiting go first
+    int uploadedFrame = -1;
 };
 
 struct LottieAnimationRenderer {
+    // how many imgui frames widget can be not drawn before animation stop render
+    static constexpr int DEFAULT_SUSPEND_FRAMES = 10;
+    // how many imgui frames widget can be not drawn before animation will be removed
+    static constexpr int DEFAULT_EVICT_FRAMES = 60 * 60;
+
     LottieRenderThread renderThread;
 
-    std::mutex animationsPresentMutex;
+    int suspendAfterFrames = DEFAULT_SUSPEND_FRAMES;
+    int evictAfterFrames = DEFAULT_EVICT_FRAMES;
+
+    // how much one sync() can upload, other frames wait for next imgui frame, 0 mean no limit.
+    // Time budget used only with realtime clock, so headless runs upload same frames every time
+    static constexpr size_t DEFAULT_UPLOAD_BUDGET_BYTES = 0;
+    static constexpr int DEFAULT_UPLOAD_BUDGET_US = 2000;
+    size_t uploadBudgetBytes = DEFAULT_UPLOAD_BUDGET_BYTES;
+    int uploadBudget_us = DEFAULT_UPLOAD_BUDGET_US;
+    uint64_t uploadsDeferred = 0;
+    // reused array for animations with frame waiting for upload
+    std::vector<LottieAnimDesc *> uploadQueue;
+    // reused array for animations which should be removed
+    std::vector<ImGuiID> evicted;
+
+    // animations known on main thread, used only from main thread so not need lock
     std::unordered_map<ImGuiID, LottieAnimDesc> animationsPresent;
 
-    ImGuiID match(const char *path, int w, int h, bool loop, int rate) {
+    // config of handles, evicted animation will be loaded again when handle drawn
+    struct HandleConfig {
+        std::string path;
+        // canvas size, handle keeps it when scale of framebuffer changed
+        int w = 0, h = 0;
+        bool loop = false;
+        int rate = 0;
+        // playback set by host, sent again when evicted animation loaded
+        bool segment = false;
+        std::string marker;
+        int startFrame = 0;
+        int endFrame = -1;
+        bool segmentLoop = false;
+        float speed = 1.f;
+        // live handles created for this animation
+        int refs = 0;
+    };
+    std::unordered_map<ImGuiID, HandleConfig> handles;
+
+    // animations drawn on current imgui frame, sent to render thread as one batch on sync()
+    std::vector<ImGuiID> submitted;
+    std::vector<int> submittedPriorities;
+    LottieRenderCommand batchCommand;
+
+    // textures for frames of all animations, used only from main thread
+    LottieAtlas atlas;
+    std::unique_ptr<LottieTextureBackend> backend;
+#ifdef IMLOTTIE_DX11_IMPLEMENTATION
+    // set when default backend used, it receive device from sync()
+    LottieDX11Backend *dx11Backend = nullptr;
+#endif // IMLOTTIE_DX11_IMPLEMENTATION
+
+    // Widget size in framebuffer pixels rounded up to bucket, nearby sizes share one canvas
+    // and texture filtering scales it, so resize of panel not create animation for every pixel.
+    // Step of buckets is 1/8 of size, canvas is at most 1/8 bigger than widget
+    static constexpr int BUCKET_MIN_STEP = 4;
+
+    static int canvasBucket(float size, float scale) {
+        const int px = std::max<int>((int)std::ceil(size * (scale > 0.f ? scale : 1.f)), LottieAnim::DEFAULT_SIZE);
+        int step = BUCKET_MIN_STEP;
+        while (step * 16 <= px) {
+            step *= 2;
+        }
+        return (px + step - 1) / step * step;
+    }
+
+    ImGuiID match(const char *path, float width, float height, bool loop, int rate) {
+        // HiDPI displays get frames with resolution of framebuffer
+        const ImVec2 scale = ImGui::GetIO().DisplayFramebufferScale;
+        return matchCanvas(path, canvasBucket(width, scale.x), canvasBucket(height, scale.y), loop, rate);
+    }
+
+    ImGuiID matchCanvas(const char *path, int w, int h, bool loop, int rate) {
         if (!path || 0 == *path) {
-            return false;
+            return BAD_PICTUREID;
         }
 
-        std::lock_guard<std::mutex> lock(animationsPresentMutex);
         ImGuiID propsHash = LottieAnim::getPropsHash(path, w, h, loop, rate);
         auto it = animationsPresent.find(propsHash);
         if (it == animationsPresent.end()) {
             ImVec2 prefferedSize;
-            prefferedSize.x = (float)std::max<int>(w, LottieAnim::DEFAULT_SIZE);
-            prefferedSize.y = (float)std::max<int>(h, LottieAnim::DEFAULT_SIZE);
+            prefferedSize.x = (float)w;
+            prefferedSize.y = (float)h;
             LottieAnimDesc animDesc;
             animDesc.pid = propsHash;
             animDesc.size = prefferedSize;
+            animDesc.lastSeenFrame = ImGui::GetFrameCount();
+            animDesc.readyFrames = std::make_shared<LottieReadyFrames>();
             animationsPresent.insert({propsHash, animDesc});
 
             LottieRenderCommand command;
@@ -498,6 +3444,7 @@ struct LottieAnimationRenderer {
             command.loop = loop;
             command.rate = rate;
             command.pid = propsHash;
+            command.readyFrames = animDesc.readyFrames;
             renderThread.addCommand(command);
             return propsHash;
         }
@@ -505,19 +3452,117 @@ struct LottieAnimationRenderer {
         return propsHash;
     }
 
-    bool render(ImGuiID pid) {
-        LottieRenderCommand command;
-        command.type = LottieRenderCommand::SETUP_RENDER;
-        command.pid = pid;
-        command.render = true;
-        renderThread.addCommand(command);
-        return true;
+    ImGuiID createHandle(const char *path, float width, float height, bool loop, int rate) {
+        const ImVec2 scale = ImGui::GetIO().DisplayFramebufferScale;
+        const int w = canvasBucket(width, scale.x);
+        const int h = canvasBucket(height, scale.y);
+        ImGuiID pid = matchCanvas(path, w, h, loop, rate);
+        if (pid != BAD_PICTUREID) {
+            // handles with same file and canvas share animation and its playback
+            HandleConfig &config = handles[pid];
+            if (config.refs == 0) {
+                config.path = path;
+                config.w = w;
+                config.h = h;
+                config.loop = loop;
+                config.rate = rate;
+            }
+            config.refs++;
+        }
+        return pid;
+    }
+
+    // animation removed with last handle which use it
+    void destroyHandle(ImGuiID pid) {
+        auto config = handles.find(pid);
+        if (config == handles.end() || --config->second.refs > 0) {
+            return;
+        }
+
+        handles.erase(config);
+        discard(pid);
+    }
+
+    // widget is drawn, animation visible on this frame and need its frames,
+    // returns animation description or null when animation unknown
+    const LottieAnimDesc *submit(ImGuiID pid, int priority) {
+        auto it = animationsPresent.find(pid);
+        if (it == animationsPresent.end()) {
+            // animation was evicted, but handle still alive
+            auto config = handles.find(pid);
+            if (config == handles.end()) {
+                return nullptr;
+            }
+
+            const HandleConfig &c = config->second;
+            matchCanvas(c.path.c_str(), c.w, c.h, c.loop, c.rate);
+            it = animationsPresent.find(pid);
+            if (it == animationsPresent.end()) {
+                return nullptr;
+            }
+            restorePlayback(pid, c);
+        }
+
+        // same animation can be drawn many times on frame, send it once with highest priority
+        LottieAnimDesc &desc = it->second;
+        const int frame = ImGui::GetFrameCount();
+        if (desc.submittedFrame != frame) {
+            desc.submittedFrame = frame;
+            desc.submittedIndex = submitted.size();
+            submitted.push_back(pid);
+            submittedPriorities.push_back(priority);
+        } else {
+            int &submittedPriority = submittedPriorities[desc.submittedIndex];
+            submittedPriority = std::max(submittedPriority, priority);
+        }
+        desc.lastSeenFrame = frame;
+        if (desc.suspended) {
+            suspend(desc, false);
+        }
+        return &desc;
+    }
+
+    // send all animations drawn on this frame as one command
+    void flushSubmitted() {
+        if (submitted.empty()) {
+            return;
+        }
+
+        batchCommand.type = LottieRenderCommand::SUBMIT_BATCH;
+        batchCommand.pids.assign(submitted.begin(), submitted.end());
+        batchCommand.priorities.assign(submittedPriorities.begin(), submittedPriorities.end());
+        // batch gets back vectors of older command, their capacity is reused on next frame
+        renderThread.addCommand(std::move(batchCommand));
+        submitted.clear();
+        submittedPriorities.clear();
     }
 
     void *image(ImGuiID pid) {
-        //std::lock_guard<std::mutex> lock(animationsPresentMutex);
-        auto it = std::find_if(animationsPresent.begin(), animationsPresent.end(), [pid] (auto &a) { return a.second.pid == pid; });
-        return (it == animationsPresent.end()) ? nullptr : it->second.srv;
+        const LottieAnimDesc *desc = imageDesc(pid);
+        return desc ? desc->srv : nullptr;
+    }
+
+    // animation description with its atlas slot, or null if not present
+    const LottieAnimDesc *imageDesc(ImGuiID pid) {
+        auto it = animationsPresent.find(pid);
+        return (it == animationsPresent.end()) ? nullptr : &it->second;
+    }
+
+    // stats of render thread with bytes uploaded by main thread
+    void animationStats(std::vector<LottieAnimStats> &stats) {
+        renderThread.animationStats(stats);
+        for (LottieAnimStats &st : stats) {
+            auto it = animationsPresent.find(st.pid);
+            st.uploadBytes = it != animationsPresent.end() ? it->second.uploadBytes : 0;
+        }
+    }
+
+    LottieMetrics metrics() {
+        LottieMetrics m = renderThread.renderMetrics();
+        m.uploads = atlas.uploads;
+        m.uploadBytes = atlas.uploadBytes;
+        m.uploadsDeferred = uploadsDeferred;
+        return m;
     }
 
     void play(ImGuiID pid, bool play) {
@@ -528,85 +3573,408 @@ struct LottieAnimationRenderer {
         renderThread.addCommand(command);
     }
 
+    // frames startFrame..endFrame or of marker (when not empty), played from first frame of segment
+    void playSegment(ImGuiID pid, const char *marker, int startFrame, int endFrame, bool loop) {
+        auto config = handles.find(pid);
+        if (config != handles.end()) {
+            HandleConfig &c = config->second;
+            c.segment = true;
+            c.marker = marker ? marker : "";
+            c.startFrame = startFrame;
+            c.endFrame = endFrame;
+            c.segmentLoop = loop;
+        }
+
+        LottieRenderCommand command;
+        command.type = LottieRenderCommand::SETUP_SEGMENT;
+        command.pid = pid;
+        command.path = marker ? marker : "";
+        command.startFrame = startFrame;
+        command.endFrame = endFrame;
+        command.loop = loop;
+        renderThread.addCommand(command);
+    }
+
+    void seek(ImGuiID pid, int frame) {
+        LottieRenderCommand command;
+        command.type = LottieRenderCommand::SETUP_SEEK;
+        command.pid = pid;
+        command.startFrame = frame;
+        renderThread.addCommand(command);
+    }
+
+    void setSpeed(ImGuiID pid, float speed) {
+        auto config = handles.find(pid);
+        if (config != handles.end()) {
+            config->second.speed = speed;
+        }
+
+        LottieRenderCommand command;
+        command.type = LottieRenderCommand::SETUP_SPEED;
+        command.pid = pid;
+        command.speed = speed;
+        renderThread.addCommand(command);
+    }
+
+    // animation of handle created again, it continue with segment and speed of handle
+    void restorePlayback(ImGuiID pid, HandleConfig c) {
+        if (c.segment) {
+            playSegment(pid, c.marker.c_str(), c.startFrame, c.endFrame, c.segmentLoop);
+        }
+        if (c.speed != 1.f) {
+            setSpeed(pid, c.speed);
+        }
+    }
+
+    void suspend(LottieAnimDesc &desc, bool suspended) {
+        desc.suspended = suspended;
+
+        LottieRenderCommand command;
+        command.type = LottieRenderCommand::SETUP_SUSPEND;
+        command.pid = desc.pid;
+        command.suspend = suspended;
+        renderThread.addCommand(command);
+    }
+
+    // stop render animations which widgets were not drawn some frames, and remove long unused
+    void updateVisibility(int frame) {
+        evicted.clear();
+        for (auto &it : animationsPresent) {
+            LottieAnimDesc &desc = it.second;
+            const int unseenFrames = frame - desc.lastSeenFrame;
+            if (unseenFrames > evictAfterFrames) {
+                evicted.push_back(desc.pid);
+            } else if (unseenFrames > suspendAfterFrames && !desc.suspended) {
+                suspend(desc, true);
+            }
+        }
+
+        for (ImGuiID pid : evicted) {
+            discard(pid);
+        }
+    }
+
     void discard(ImGuiID pid) {
         LottieRenderCommand command;
         command.type = LottieRenderCommand::DISCARD_PID;
         command.pid = pid;
         renderThread.addCommand(command);
 
-        std::lock_guard<std::mutex> lock(animationsPresentMutex);
-        auto it = std::find_if(animationsPresent.begin(), animationsPresent.end(), [pid] (auto &a) { return a.second.pid == pid; });
+        auto it = animationsPresent.find(pid);
         if (it != animationsPresent.end()) {
+            atlas.free(it->second.slot);
             animationsPresent.erase(it);
         }
     }
 
 #ifdef IMLOTTIE_DX11_IMPLEMENTATION
     void uploadReadyFramesToSysTex(ID3D11Device *pd3dDevice, ID3D11DeviceContext* ctx) {
-        // prepared frames stored in readyFrames array now (in system memory)
-        // but need move those to gpu memory with textures
-        ReadyFrame readyFrame;
-        while (renderThread.popReadyFrame(readyFrame)) {
-            const auto &it = renderThread.animations.find(readyFrame.pid);
-
-            if (!it->second.texture) {
-                it->second.createTextureFromData(readyFrame.data.data(), pd3dDevice);
-                auto rit = std::find_if(animationsPresent.begin(), animationsPresent.end(), [pid = it->second.pid] (auto &a) { return a.second.pid == pid; });
-                if (rit != animationsPresent.end())
-                    rit->second.srv = it->second.srv;
+        if (dx11Backend) {
+            dx11Backend->device = pd3dDevice;
+            dx11Backend->ctx = ctx;
+        }
+        uploadReadyFramesToSysTex();
+    }
+#endif // IMLOTTIE_DX11_IMPLEMENTATION
+
+    void uploadReadyFramesToSysTex() {
+        // prepared frames stored in readyFrames of animations now (in system memory)
+        // but need move those to gpu memory with textures, only newest frame of every
+        // animation is taken, older ones were replaced by render thread
+        const int frame = ImGui::GetFrameCount();
+        uploadQueue.clear();
+        for (auto &it : animationsPresent) {
+            if (it.second.readyFrames->pending()) {
+                uploadQueue.push_back(&it.second);
+            }
+        }
+
+        // visible widgets first, then animations which slot waits for new frame longest
+        std::sort(uploadQueue.begin(), uploadQueue.end(), [frame] (const LottieAnimDesc *a, const LottieAnimDesc *b) {
+            const bool visibleA = a->lastSeenFrame == frame;
+            const bool visibleB = b->lastSeenFrame == frame;
+            if (visibleA != visibleB) {
+                return visibleA;
+            }
+            if (a->uploadedFrame != b->uploadedFrame) {
+                return a->uploadedFrame < b->uploadedFrame;
+            }
+            return a->pid < b->pid;
+        });
+
+        // burst of frames (many animations shown at once) is spread over few imgui frames, not
+        // uploaded frame stays in triple buffer and replaced there when newer one rendered
+        const auto start = std::chrono::steady_clock::now();
+        const uint64_t uploadedBefore = atlas.uploadBytes;
+        const bool timed = uploadBudget_us > 0 && renderThread.clock->realtime();
+        for (size_t i = 0; i < uploadQueue.size(); ++i) {
+            // at least one frame uploaded on every call, so big frames not wait forever
+            const bool bytesSpent = uploadBudgetBytes > 0 && atlas.uploadBytes - uploadedBefore >= uploadBudgetBytes;
+            const bool timeSpent = timed && std::chrono::steady_clock::now() - start >= std::chrono::microseconds(uploadBudget_us);
+            if (i > 0 && (bytesSpent || timeSpent)) {
+                uploadsDeferred += uploadQueue.size() - i;
                 break;
-            } else {
-                it->second.updateTextureFromData(readyFrame.data.data(), ctx);
+            }
+
+            uploadReadyFrame(*uploadQueue[i], frame);
+        }
+
+        // pages left by discarded or resized animations not keep textures, but widgets of this
+        // frame can draw them yet
+        atlas.trim(backend.get(), frame);
+        reclaimLentBuffers();
+        lendBuffers();
+    }
+
+    void uploadReadyFrame(LottieAnimDesc &desc, int frame) {
+        if (!renderThread.takeReadyFrame(*desc.readyFrames)) {
+            return;
+        }
+
+        ReadyFrame &readyFrame = desc.readyFrames->front();
+        // canvas can be scaled by quality governor, slot follows frame size
+        if (desc.slot.valid() && (desc.slot.w != (int)readyFrame.size.x || desc.slot.h != (int)readyFrame.size.y)) {
+            atlas.free(desc.slot);
+            // page of old slot is retired when it empty, texture lives until this frame drawn
+            desc.srv = nullptr;
+        }
+        if (!desc.slot.valid()) {
+            atlas.alloc((int)readyFrame.size.x, (int)readyFrame.size.y, desc.slot);
+            desc.version = LottieFrameSource::NO_VERSION;
+        }
+
+        // slot has other pixels than frame damage based on, it updated whole
+        LottieRect rect = readyFrame.damage;
+        if (desc.version != readyFrame.baseVersion) {
+            rect = LottieRect::sized(0, 0, desc.slot.w, desc.slot.h);
+        }
+
+        const uint64_t uploadedBefore = atlas.uploadBytes;
+        void *texture = atlas.upload(desc.slot, readyFrame.data, rect, *backend);
+        desc.uploadBytes += atlas.uploadBytes - uploadedBefore;
+        if (texture) {
+            desc.srv = texture;
+            desc.version = readyFrame.version;
+        } else {
+            desc.version = LottieFrameSource::NO_VERSION;
+        }
+
+        // frame data now in texture, buffer can be used for next frames, lent memory
+        // goes back to backend, it was copied by gpu and can't be written now
+        if (readyFrame.data.lent) {
+            backend->reclaimBuffer(readyFrame.data.lent);
+            readyFrame.data = LottieFrameBuffer();
+        } else {
+            renderThread.framePool.release(readyFrame.data);
+        }
+        desc.uploadedFrame = frame;
+    }
+
+    // lent memory not needed by pool goes back to backend
+    std::vector<LottieFrameBuffer> reclaimedBuffers;
+
+    void reclaimLentBuffers() {
+        LottieFramePool &pool = renderThread.framePool;
+        {
+            std::lock_guard<std::mutex> lock(pool.mutex);
+            std::swap(reclaimedBuffers, pool.reclaimed);
+        }
+
+        for (LottieFrameBuffer &buffer : reclaimedBuffers) {
+            backend->reclaimBuffer(buffer.lent);
+        }
+        reclaimedBuffers.clear();
+    }
+
+    // new memory lent for frame sizes which render thread took from own memory since previous sync
+    std::vector<std::pair<uint64_t, int>> lendRequests;
+
+    void lendBuffers() {
+        LottieFramePool &pool = renderThread.framePool;
+        lendRequests.clear();
+        {
+            std::lock_guard<std::mutex> lock(pool.mutex);
+            for (auto &it : pool.lentWanted) {
+                if (it.second > 0) {
+                    const auto lentIt = pool.lentBuckets.find(it.first);
+                    const int lentFree = lentIt != pool.lentBuckets.end() ? (int)lentIt->second.size() : 0;
+                    lendRequests.emplace_back(it.first, std::min(it.second, LottieFramePool::MAX_LENT_BUFFERS - lentFree));
+                    it.second = 0;
+                }
             }
         }
 
-        renderThread.curtime = (float)ImGui::GetTime() * 1000.f;
+        for (const auto &request : lendRequests) {
+            for (int i = 0; i < request.second; ++i) {
+                LottieFrameBuffer buffer;
+                buffer.width = int(request.first >> 32);
+                buffer.height = int(uint32_t(request.first));
+                buffer.pixels = backend->lendBuffer(buffer.width, buffer.height, buffer.pitch, buffer.lent);
+                if (!buffer.pixels) {
+                    break;
+                }
+                pool.release(buffer);
+            }
+        }
     }
-#endif // IMLOTTIE_DX11_IMPLEMENTATION
 
-    LottieAnimationRenderer() {
-        std::thread independedThread([this] () { renderThread.execute(); });
-        independedThread.detach();
+    LottieAnimationRenderer(int workersCount, LottieTextureBackend *textureBackend, LottieClock *clock) {
+        backend.reset(textureBackend ? textureBackend : createDefaultBackend());
+        renderThread.setClock(clock);
+        renderThread.independentThread = std::thread([this, workersCount] () { renderThread.execute(workersCount); });
     }
 
     ~LottieAnimationRenderer() {
         renderThread.terminating.store(true);
+        renderThread.wakeup();
+        if (renderThread.independentThread.joinable()) {
+            renderThread.independentThread.join();
+        }
+        for (auto &it : animationsPresent) {
+            renderThread.releaseReadyFrames(*it.second.readyFrames);
+        }
+        renderThread.framePool.trim();
+        reclaimLentBuffers();
+        atlas.release(backend.get());
+    }
+
+    LottieTextureBackend *createDefaultBackend() {
+#if defined(IMLOTTIE_DX11_IMPLEMENTATION)
+        dx11Backend = new LottieDX11Backend();
+        return dx11Backend;
+#elif defined(IMLOTTIE_OPENGL_IMPLEMENTATION)
+        return new LottieOpenGLBackend();
+#else
+        return new LottieMemoryBackend();
+#endif
+    }
+};
+
+namespace detail {
+    // adds item for widget, returns false when widget not visible
+    bool lottieItem(ImGuiWindow *window, ImGuiID id, const ImVec2 &size, ImRect &bb) {
+        const ImGuiStyle &style = GImGui->Style;
+        const ImVec2 pos = window->DC.CursorPos;
+
+        bb = ImRect(pos, ImVec2(pos.x + size.x, pos.y + size.y));
+        ImGui::ItemSize(bb, style.FramePadding.y);
+        return ImGui::ItemAdd(bb, id);
+    }
+
+    void lottieImage(ImGuiWindow *window, const ImRect &bb, const LottieAnimDesc *desc) {
+        if (desc && desc->srv) {
+            // canvas of size bucket can have little other proportions than widget, it fitted
+            // to widget without stretching, so animation looks same as with canvas of widget size
+            const ImVec2 size(bb.Max.x - bb.Min.x, bb.Max.y - bb.Min.y);
+            const float scale = std::min(size.x / desc->size.x, size.y / desc->size.y);
+            const ImVec2 drawn(desc->size.x * scale, desc->size.y * scale);
+            const ImVec2 min(bb.Min.x + (size.x - drawn.x) * 0.5f, bb.Min.y + (size.y - drawn.y) * 0.5f);
+            const ImVec2 max(min.x + drawn.x, min.y + drawn.y);
+            window->DrawList->AddImage((void *)desc->srv, min, max, desc->slot.uv0, desc->slot.uv1, ImGui::GetColorU32(ImVec4(1, 1, 1, 1)));
+        } else {
+            // placeholder while animation loaded and first frame rendered
+            window->DrawList->AddRectFilled(bb.Min, bb.Max, ImGui::GetColorU32(ImGuiCol_FrameBg));
+        }
     }
+}
+
+// Handle of animation, created once and drawn every frame without searching animation by path
+struct LottieHandle {
+    ImGuiID pid = BAD_PICTUREID;
+
+    bool valid() const { return pid != BAD_PICTUREID; }
 };
 
-void LottieAnimation(const char *path, const ImVec2 &size, bool loop, int rate) {
-    ImVec2 pos, centre;
+LottieHandle createHandle(const char *path, const ImVec2 &size, bool loop, int rate) {
+    LottieHandle handle;
+    if (detail::g_lottieRenderer) {
+        handle.pid = detail::g_lottieRenderer->createHandle(path, size.x, size.y, loop, rate);
+    }
+    return handle;
+}
+
+void destroyHandle(LottieHandle &handle) {
+    if (detail::g_lottieRenderer && handle.valid()) {
+        detail::g_lottieRenderer->destroyHandle(handle.pid);
+    }
+    handle.pid = BAD_PICTUREID;
+}
+
+// Plays frames startFrame..endFrame (-1 for last frame) of animation, starting from startFrame now.
+// Not looped segment stays on its last frame. Prerendered and baked frames are limited to segment
+void playSegment(LottieHandle handle, int startFrame, int endFrame, bool loop) {
+    if (detail::g_lottieRenderer && handle.valid()) {
+        detail::g_lottieRenderer->playSegment(handle.pid, nullptr, startFrame, endFrame, loop);
+    }
+}
+
+// Plays segment of marker set in After Effects, whole animation when file has not such marker
+void playMarker(LottieHandle handle, const char *marker, bool loop) {
+    if (detail::g_lottieRenderer && handle.valid() && marker) {
+        detail::g_lottieRenderer->playSegment(handle.pid, marker, 0, -1, loop);
+    }
+}
+
+// Shows frame of animation now and continue playing from it, frame clamped to played segment
+void seek(LottieHandle handle, int frame) {
+    if (detail::g_lottieRenderer && handle.valid()) {
+        detail::g_lottieRenderer->seek(handle.pid, frame);
+    }
+}
+
+// Speed of playback, 1 is normal, 2 twice faster, 0.5 twice slower
+void setSpeed(LottieHandle handle, float speed) {
+    if (detail::g_lottieRenderer && handle.valid()) {
+        detail::g_lottieRenderer->setSpeed(handle.pid, speed);
+    }
+}
+
+// Draws animation by handle, widget only marks animation as drawn, all animations of
+// imgui frame will be sent to render thread as one batch on sync()
+// priority - 0 for background, 1 normal, more for focused window, hovered or big widgets,
+//            animations with higher priority rendered first when thread has no time for all
+void LottieAnimation(LottieHandle handle, const ImVec2 &size, int priority = LottieAnim::DEFAULT_PRIORITY) {
     ImGuiWindow *window = ImGui::GetCurrentWindow();
-    if (window->SkipItems)
+    if (window->SkipItems || !handle.valid())
         return;
 
-    ImGuiContext &g = *GImGui;
-    const ImGuiStyle &style = g.Style;
-    const ImGuiID id = window->GetID(path);
+    ImRect bb(ImVec2(0, 0), ImVec2(0, 0));
+    if (!detail::lottieItem(window, window->GetID((int)handle.pid), size, bb))
+        return;
 
-    pos = window->DC.CursorPos;
+    assert(detail::g_lottieRenderer);
+    if (detail::g_lottieRenderer) {
+        detail::lottieImage(window, bb, detail::g_lottieRenderer->submit(handle.pid, priority));
+    }
+}
 
-    const ImRect bb(pos, ImVec2(pos.x + size.x, pos.y + size.y));
-    ImGui::ItemSize(bb, style.FramePadding.y);
+void LottieAnimation(const char *path, const ImVec2 &size, bool loop, int rate, int priority = LottieAnim::DEFAULT_PRIORITY) {
+    ImGuiWindow *window = ImGui::GetCurrentWindow();
+    if (window->SkipItems)
+        return;
 
-    centre = bb.GetCenter();
-    if (!ImGui::ItemAdd(bb, id))
+    ImRect bb(ImVec2(0, 0), ImVec2(0, 0));
+    if (!detail::lottieItem(window, window->GetID(path), size, bb))
         return;
 
     assert(detail::g_lottieRenderer);
     if (detail::g_lottieRenderer) {
         ImGuiID rid = detail::g_lottieRenderer->match(path, size.x, size.y, loop, rate);
-        detail::g_lottieRenderer->render(rid); // not really render, just send command to stack we need this texture
-        void *texture = detail::g_lottieRenderer->image(rid); // get texture from renderer or null if not present
-        window->DrawList->AddImage((void *)texture, bb.Min, bb.Max, ImVec2(0, 0), ImVec2(1, 1), ImGui::GetColorU32(ImVec4(1, 1, 1, 1)));
+        // not really render, just mark we need this texture, returns atlas slot or null if not present
+        detail::lottieImage(window, bb, detail::g_lottieRenderer->submit(rid, priority));
     } else {
         window->DrawList->AddRectFilled(bb.Min, bb.Max, 0xffffffff);
     }
 }
 
 
-void init() {
-    detail::g_lottieRenderer = new LottieAnimationRenderer();
+// workersCount - how many threads render animations, 0 mean one per core
+// backend - storage for textures, renderer take ownership, when null backend selected
+//           by IMLOTTIE_DX11_IMPLEMENTATION/IMLOTTIE_OPENGL_IMPLEMENTATION or memory one
+// backend and clock are owned by renderer, null for default ones. LottieManualClock makes
+// scheduler deterministic, host steps time with advance() and waits render thread by waitIdle()
+void init(int workersCount = LottieWorkerPool::DEFAULT_WORKERS, LottieTextureBackend *backend = nullptr, LottieClock *clock = nullptr) {
+    detail::g_lottieRenderer = new LottieAnimationRenderer(workersCount, backend, clock);
 }
 
 void destroy() {
@@ -615,9 +3983,161 @@ void destroy() {
 }
 
 
+// Waits until render thread finished all work due at current time of its clock and loaders
+// parsed all files, with manual clock frames ready after it are same on every run
+void waitIdle() {
+    if (detail::g_lottieRenderer) {
+        detail::g_lottieRenderer->renderThread.waitIdle();
+    }
+}
+
+// Returns depth of render thread queues and how many commands and frames were dropped
+LottieQueueStats queueStats() {
+    return detail::g_lottieRenderer ? detail::g_lottieRenderer->renderThread.queueStats() : LottieQueueStats{};
+}
+
+// Setup how many imgui frames animation can be not drawn before it will be suspended,
+// and how many before it will be removed with its frames and texture slot
+void setVisibilityPolicy(int suspendAfterFrames, int evictAfterFrames) {
+    if (detail::g_lottieRenderer) {
+        detail::g_lottieRenderer->suspendAfterFrames = suspendAfterFrames;
+        detail::g_lottieRenderer->evictAfterFrames = evictAfterFrames;
+    }
+}
+
+// Returns level of quality governor and load of render thread
+LottieQualityState qualityState() {
+    return detail::g_lottieRenderer ? detail::g_lottieRenderer->renderThread.qualityState() : LottieQualityState{};
+}
+
+// Enable or disable automatic quality reduction, when disabled full quality restored
+void setQualityGovernor(bool enabled) {
+    if (detail::g_lottieRenderer) {
+        detail::g_lottieRenderer->renderThread.governorEnabled.store(enabled, std::memory_order_relaxed);
+    }
+}
+
+// Copies counters of all animations, they updated by render thread few times per second.
+// Call from main thread, upload bytes are counted by sync()
+void animationStats(std::vector<LottieAnimStats> &stats) {
+    stats.clear();
+    if (detail::g_lottieRenderer) {
+        detail::g_lottieRenderer->animationStats(stats);
+    }
+}
+
+// Counters of all animations together with queues, memory and quality, main thread only
+LottieMetrics metrics() {
+    return detail::g_lottieRenderer ? detail::g_lottieRenderer->metrics() : LottieMetrics{};
+}
+
+// Window with metrics of renderer and table of animations, for debug overlay of host
+void ShowMetricsWindow(bool *open = nullptr) {
+    if (!detail::g_lottieRenderer) {
+        return;
+    }
+
+    if (!ImGui::Begin("Lottie Metrics", open)) {
+        ImGui::End();
+        return;
+    }
+
+    const LottieMetrics m = metrics();
+    ImGui::Text("animations %d, sources %d", (int)m.animations, (int)m.sources);
+    ImGui::Text("render time p50 %.0f us, p99 %.0f us, busy %.0f%%", m.renderUsP50, m.renderUsP99, m.quality.busy * 100.f);
+    ImGui::Text("frames shown %llu, rendered %llu, dropped %llu, skipped %llu, misses %llu",
+                (unsigned long long)m.framesShown, (unsigned long long)m.framesRendered, (unsigned long long)m.framesDropped,
+                (unsigned long long)m.framesSkipped, (unsigned long long)m.deadlineMisses);
+    ImGui::Text("reused %.1f%% (baked %llu, cached %llu, unchanged %llu)", m.reuseRate * 100.f,
+                (unsigned long long)m.bakedHits, (unsigned long long)m.cacheHits, (unsigned long long)m.unchangedHits);
+    ImGui::Text("uploads %llu (deferred %llu), %.1f MB", (unsigned long long)m.uploads, (unsigned long long)m.uploadsDeferred,
+                m.uploadBytes / (1024.f * 1024.f));
+    ImGui::Text("queues: commands %d (overflowed %llu), ready frames %d (replaced %llu)",
+                (int)m.queues.commandsDepth, (unsigned long long)m.queues.commandsOverflowed,
+                (int)m.queues.readyFramesDepth, (unsigned long long)m.queues.readyFramesDropped);
+    ImGui::Text("memory %.1f / %.1f MB, peak %.1f MB, evictions %llu", m.memory.current / (1024.f * 1024.f),
+                m.memory.budget / (1024.f * 1024.f), m.memory.peak / (1024.f * 1024.f), (unsigned long long)m.memory.evictions);
+    ImGui::Text("quality level %d, scale %.2f%s", m.quality.level, m.quality.canvasScale, m.quality.lowPriorityHalfRate ? ", low priority half rate" : "");
+
+    static std::vector<LottieAnimStats> stats;
+    animationStats(stats);
+    const ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_Resizable;
+    if (ImGui::BeginTable("animations", 10, flags)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("file");
+        ImGui::TableSetupColumn("size");
+        ImGui::TableSetupColumn("frame");
+        ImGui::TableSetupColumn("prio");
+        ImGui::TableSetupColumn("p50/p99 us");
+        ImGui::TableSetupColumn("shown");
+        ImGui::TableSetupColumn("rendered");
+        ImGui::TableSetupColumn("reused");
+        ImGui::TableSetupColumn("dropped/skipped/misses");
+        ImGui::TableSetupColumn("upload KB");
+        ImGui::TableHeadersRow();
+        for (const LottieAnimStats &st : stats) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(st.path.c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%dx%d%s%s", st.width, st.height, st.baked ? " baked" : "", st.suspended ? " suspended" : "");
+            ImGui::TableNextColumn();
+            ImGui::Text("%d/%d", st.frame, st.totalFrames);
+            ImGui::TableNextColumn();
+            ImGui::Text("%d", st.priority);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0f/%.0f", st.renderUsP50, st.renderUsP99);
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", st.framesShown);
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", st.framesRendered);
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", st.framesReused);
+            ImGui::TableNextColumn();
+            ImGui::Text("%u/%u/%u", st.framesDropped, st.framesSkipped, st.deadlineMisses);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", st.uploadBytes / 1024.f);
+        }
+        ImGui::EndTable();
+    }
+    ImGui::End();
+}
+
+// Returns how many bytes take models and frames of animations, peak and budget
+LottieMemoryStats memoryStats() {
+    return detail::g_lottieRenderer ? detail::g_lottieRenderer->renderThread.memoryStats() : LottieMemoryStats{};
+}
+
+// Setup how many bytes can take models and frames of all animations, least recently shown
+// animations lose caches and models when budget exceeded, 0 mean no limit
+void setMemoryBudget(size_t bytes) {
+    if (detail::g_lottieRenderer) {
+        detail::g_lottieRenderer->renderThread.memoryBudget.store(bytes, std::memory_order_relaxed);
+    }
+}
+
+// Setup how many bytes can take all frames of animation for baking, baked animation rendered
+// once and later only copied, 0 disable baking. Used for animations loaded after call
+void setBakeBudget(size_t bytesPerAnimation) {
+    if (detail::g_lottieRenderer) {
+        detail::g_lottieRenderer->renderThread.bakeBudget.store(bytesPerAnimation, std::memory_order_relaxed);
+    }
+}
+
+// Setup how much sync() can copy to textures per call, frames beyond budget uploaded on next
+// frames, visible animations first. 0 mean no limit, time budget not used with manual clock
+void setUploadBudget(size_t bytes, int microseconds) {
+    if (detail::g_lottieRenderer) {
+        detail::g_lottieRenderer->uploadBudgetBytes = bytes;
+        detail::g_lottieRenderer->uploadBudget_us = std::max(microseconds, 0);
+    }
+}
+
 template<typename ... Args>
 void sync(Args... args) {
     if (detail::g_lottieRenderer) {
+        detail::g_lottieRenderer->flushSubmitted();
+        detail::g_lottieRenderer->updateVisibility(ImGui::GetFrameCount());
         detail::g_lottieRenderer->uploadReadyFramesToSysTex(args...);
     }
 } 
@@ -636,6 +636,17 @@ public:
     friend VDebug &operator<<(VDebug &os, const VRect &o);
 
     VRect intersected(const VRect &r) const { return *this & r; }
+    VRect united(const VRect &r) const {
+        if (empty()) return r;
+        if (r.empty()) return *this;
+
+        VRect tmp;
+        tmp.x1 = std::min(x1, r.x1);
+        tmp.y1 = std::min(y1, r.y1);
+        tmp.x2 = std::max(x2, r.x2);
+        tmp.y2 = std::max(y2, r.y2);
+        return tmp;
+    }
     VRect operator&(const VRect &r) const {
         if (empty()) return VRect();
 
@@ -3122,8 +3133,16 @@ public:
         auto first = mKeyFrames.front().mStartFrame;
         auto last = mKeyFrames.back().mEndFrame;
 
-        return !((first > prevFrame  && first > curFrame) ||
-                 (last < prevFrame  && last < curFrame));
+        if ((first > prevFrame  && first > curFrame) ||
+            (last < prevFrame  && last < curFrame)) return false;
+
+        // hold keyframe keeps its start value till next keyframe
+        for(const auto &keyFrame : mKeyFrames) {
+            if (prevFrame >= keyFrame.mStartFrame && prevFrame < keyFrame.mEndFrame)
+                return keyFrame.mInterpolator ||
+                       !(curFrame >= keyFrame.mStartFrame && curFrame < keyFrame.mEndFrame);
+        }
+        return true;
     }
 
 public:
@@ -4202,6 +4221,7 @@ public:
     void buildRenderTree();
     const LOTLayerNode * renderTree()const;
     bool render(const Surface &surface);
+    const VRect &damage() const { return mDamage;}
     void setValue(const std::string &keypath, LOTVariant &value);
 private:
     VBitmap                                     mSurface;
@@ -4210,8 +4230,12 @@ private:
     LOTCompositionData                         *mCompData{nullptr};
     LOTLayerItem                               *mRootLayer{nullptr};
     VArenaAlloc                                 mAllocator{2048};
+    VRect                                       mDamage;
+    VSize                                       mRenderedSize;
     int                                         mCurFrameNo;
     bool                                        mKeepAspectRatio{true};
+    bool                                        mValueChanged{false};
+    bool                                        mFullDamage{true};
 };
 
 class LOTLayerMaskItem;
@@ -4301,9 +4325,17 @@ public:
     const char* name() const {return mLayerData->name();}
     virtual bool resolveKeyPath(LOTKeyPath &keyPath, uint depth, LOTVariant &value);
     VBitmap& bitmap() {return mRenderBuffer;}
+    // layer looks different than after previous update
+    bool changed() const {return mChanged || mContentChanged;}
+    // adds area which changed since previous render to region
+    virtual void damage(VRect &region, bool force);
+    // layer was drawn through bitmap covering rect
+    void setBlendRect(const VRect &rect) { mBlendRect = mBlendRect.united(rect);}
 protected:
     virtual void preprocessStage(const VRect& clip) = 0;
     virtual void updateContent() = 0;
+    virtual bool contentChanged() const {return false;}
+    void setDrawn(bool drawn) { if (mDrawn != drawn) mChanged = true; mDrawn = drawn;}
     inline VMatrix combinedMatrix() const {return mCombinedMatrix;}
     inline int frameNo() const {return mFrameNo;}
     inline float combinedAlpha() const {return mCombinedAlpha;}
@@ -4321,6 +4353,13 @@ protected:
     int                                         mFrameNo{-1};
     DirtyFlag                                   mDirtyFlag{DirtyFlagBit::All};
     bool                                        mComplexContent{false};
+    VRect                                       mDrawnRect;
+    VRect                                       mPrevDrawnRect;
+    VRect                                       mBlendRect;
+    VRect                                       mPrevBlendRect;
+    bool                                        mChanged{true};
+    bool                                        mContentChanged{false};
+    bool                                        mDrawn{false};
     std::unique_ptr<LOTCApiData>                mCApiData;
 };
 
@@ -4330,11 +4369,13 @@ public:
     explicit LOTCompLayerItem(LOTLayerData *layerData, VArenaAlloc* allocator);
 
     void render(VPainter *painter, const VRle &mask, const VRle &matteRle) final;
+    void damage(VRect &region, bool force) final;
     void buildLayerNode() final;
     bool resolveKeyPath(LOTKeyPath &keyPath, uint depth, LOTVariant &value) override;
 protected:
     void preprocessStage(const VRect& clip) final;
     void updateContent() final;
+    bool contentChanged() const final;
 private:
     void renderHelper(VPainter *painter, const VRle &mask, const VRle &matteRle);
     void renderMatteLayer(VPainter *painter, const VRle &inheritMask, const VRle &matteRle,
@@ -4370,6 +4411,7 @@ public:
 protected:
     void preprocessStage(const VRect& clip) final;
     void updateContent() final;
+    bool contentChanged() const final;
     std::vector<VDrawable *>             mDrawableList;
     LOTContentGroupItem                 *mRoot{nullptr};
 };
@@ -4455,6 +4497,8 @@ public:
     virtual void update(int frameNo, const VMatrix &parentMatrix, float parentAlpha, const DirtyFlag &flag) = 0;   virtual void renderList(std::vector<VDrawable *> &){}
     virtual bool resolveKeyPath(LOTKeyPath &, uint, LOTVariant &) {return false;}
     virtual ContentType type() const {return ContentType::Unknown;}
+    // content looks different than after previous update
+    virtual bool changed() const {return true;}
 };
 
 class LOTContentGroupItem: public LOTContentItem
@@ -4469,6 +4513,7 @@ public:
     void processPaintItems(std::vector<LOTPathDataItem *> &list);
     void renderList(std::vector<VDrawable *> &list) override;
     ContentType type() const final {return ContentType::Group;}
+    bool changed() const override;
     const VMatrix & matrix() const { return mMatrix;}
     const char* name() const
     {
@@ -4489,6 +4534,7 @@ public:
     LOTPathDataItem(bool staticPath): mStaticPath(staticPath){}
     void update(int frameNo, const VMatrix &parentMatrix, float parentAlpha, const DirtyFlag &flag) final;
     ContentType type() const final {return ContentType::Path;}
+    bool changed() const final {return mDirtyPath;}
     bool dirty() const {return mDirtyPath;}
     const VPath &localPath() const {return mTemp;}
     void finalPath(VPath& result);
@@ -4585,6 +4631,7 @@ public:
     void update(int frameNo, const VMatrix &parentMatrix, float parentAlpha, const DirtyFlag &flag) override;
     void renderList(std::vector<VDrawable *> &list) final;
     ContentType type() const final {return ContentType::Paint;}
+    bool changed() const final {return mChanged;}
 protected:
     virtual bool updateContent(int frameNo, const VMatrix &matrix, float alpha) = 0;
 private:
@@ -4594,9 +4641,11 @@ protected:
     LOTDrawable                      mDrawable;
     VPath                            mPath;
     DirtyFlag                        mFlag;
+    float                            mAlpha{-1};
     bool                             mStaticContent;
     bool                             mRenderNodeUpdate{true};
     bool                             mContentToRender{true};
+    bool                             mChanged{true};
 };
 
 class LOTFillItem : public LOTPaintDataItem
@@ -4649,6 +4698,7 @@ public:
     explicit LOTTrimItem(LOTTrimData *data);
     void update(int frameNo, const VMatrix &parentMatrix, float parentAlpha, const DirtyFlag &flag) final;
     ContentType type() const final {return ContentType::Trim;}
+    bool changed() const final {return mDirty;}
     void update();
     void addPathItems(std::vector<LOTPathDataItem *> &list, size_t startOffset);
 private:
@@ -4989,8 +5039,21 @@ public:
     *  @param[in] frameNo Content corresponds to the @p frameNo needs to be drawn
     *  @param[in] surface Surface in which content will be drawn
     *  @param[in] keepAspectRatio whether to keep the aspect ratio while scaling the content.
+    *  @param[in] skipUnchanged don't draw when content is same as last rendered frame,
+    *             surface keeps its pixels then.
+    *  @return false if content is same as last rendered frame.
+    */
+    bool              renderSync(size_t frameNo, Surface surface, bool keepAspectRatio=true, bool skipUnchanged=false);
+
+    /**
+    *  @brief Returns area of surface changed by last renderSync() compared with frame
+    *         rendered before it, pixels outside of the area are same.
+    *  @param[out] x      area x position.
+    *  @param[out] y      area y position.
+    *  @param[out] width  area width, 0 if nothing changed.
+    *  @param[out] height area height, 0 if nothing changed.
     */
-    void              renderSync(size_t frameNo, Surface surface, bool keepAspectRatio=true);
+    void              damage(size_t &x, size_t &y, size_t &width, size_t &height) const;
 
     /**
     *  @brief Returns root layer of the composition updated with
@@ -50,11 +50,23 @@ namespace imlottie {
     double animationDuration(const std::shared_ptr<Animation> &anim) {
         return anim->duration();
     }
-    void animationRenderSync (const std::shared_ptr<Animation> &anim, int nextFrameIndex, uint32_t *data, int width, int height, int row_pitch) {
+    const std::vector<std::tuple<std::string, int, int>> &animationMarkers(const std::shared_ptr<Animation> &anim) {
+        return anim->markers();
+    }
+    bool animationRenderSync (const std::shared_ptr<Animation> &anim, int nextFrameIndex, uint32_t *data, int width, int height, int row_pitch, bool skipUnchanged, int *damage) {
         Surface surface(data, width, height, row_pitch);
         // rasterize frame to nextFrame.data, imlottie::Surface is temporary
         // structure which not save any data
-        anim->renderSync(nextFrameIndex, surface);
+        bool changed = anim->renderSync(nextFrameIndex, surface, true, skipUnchanged);
+        if (damage) {
+            size_t x, y, w, h;
+            anim->damage(x, y, w, h);
+            damage[0] = int(x);
+            damage[1] = int(y);
+            damage[2] = int(w);
+            damage[3] = int(h);
+        }
+        return changed;
     }
 } // ImGui
 
@@ -1019,8 +1031,10 @@ public:
     ;
     SW_FT_Stroker stroker;
 public:
+    // outline and stroker are scratch state, so each render thread
+    // need own copy, animations may be rasterized in parallel
     static RleTaskScheduler &instance() {
-        static RleTaskScheduler singleton;
+        static thread_local RleTaskScheduler singleton;
         return singleton;
     }
     RleTaskScheduler() {
@@ -6149,10 +6163,14 @@ void LOTCompItem::setValue(const std::string &keypath, LOTVariant &value)
 {
     LOTKeyPath key(keypath);
     mRootLayer->resolveKeyPath(key, 0, value);
+    mValueChanged = true;
 }
 
 bool LOTCompItem::update(int frameNo, const VSize &size, bool keepAspectRatio)
 {
+    // damage is set by render, surface not touched without it
+    mDamage = VRect();
+
     // check if cached frame is same as requested frame.
     if ((mViewSize == size) &&
         (mCurFrameNo == frameNo) &&
@@ -6181,7 +6199,11 @@ bool LOTCompItem::update(int frameNo, const VSize &size, bool keepAspectRatio)
         m.scale(sx, sy);
     }
     mRootLayer->update(frameNo, m, 1.0);
-    return true;
+
+    // frame is same as previous one when all layers are held or hidden
+    bool changed = mValueChanged || mRootLayer->changed();
+    mValueChanged = false;
+    return changed;
 }
 
 bool LOTCompItem::render(const imlottie::Surface &surface)
@@ -6203,6 +6225,16 @@ bool LOTCompItem::render(const imlottie::Surface &surface)
         int(surface.drawRegionWidth()), int(surface.drawRegionHeight())));
     mRootLayer->render(&painter, {}, {});
     painter.end();
+
+    // changed layers damage area where they are drawn now and where they were drawn before
+    mDamage = VRect();
+    mRootLayer->damage(mDamage, false);
+    if (mFullDamage || mRenderedSize != clip.size()) {
+        mDamage = clip;
+        mFullDamage = false;
+        mRenderedSize = clip.size();
+    }
+    mDamage = (mDamage & clip).translated(int(surface.drawRegionPosX()), int(surface.drawRegionPosY()));
     return true;
 }
 
@@ -6263,6 +6295,7 @@ void LOTLayerItem::render(VPainter *painter, const VRle &inheritMask,
     for (auto &i : renderlist) {
         painter->setBrush(i->mBrush);
         VRle rle = i->rle();
+        mDrawnRect = mDrawnRect.united(rle.boundingRect());
         if (matteRle.empty()) {
             if (mask.empty()) {
                 // no mask no matte
@@ -6287,6 +6320,22 @@ void LOTLayerItem::render(VPainter *painter, const VRle &inheritMask,
     }
 }
 
+void LOTLayerItem::damage(VRect &region, bool force)
+{
+    if (force || changed()) {
+        region = region.united(mDrawnRect).united(mPrevDrawnRect);
+    }
+    // blending of bitmap rounds pixels even where bitmap is empty, so whole
+    // area is changed when layer starts or stops to be drawn through bitmap
+    if (mBlendRect != mPrevBlendRect) {
+        region = region.united(mBlendRect).united(mPrevBlendRect);
+    }
+    mPrevDrawnRect = mDrawnRect;
+    mDrawnRect = VRect();
+    mPrevBlendRect = mBlendRect;
+    mBlendRect = VRect();
+}
+
 void LOTLayerMaskItem::preprocess(const VRect &clip)
 {
     for (auto &i : mMasks) {
@@ -6411,14 +6460,21 @@ void LOTLayerItem::update(int frameNumber, const VMatrix &parentMatrix,
                           float parentAlpha)
 {
     mFrameNo = frameNumber;
+    mChanged = false;
+    mContentChanged = false;
     // 1. check if the layer is part of the current frame
-    if (!visible()) return;
+    if (!visible()) {
+        setDrawn(false);
+        return;
+    }
 
     float alpha = parentAlpha * opacity(frameNo());
     if (vIsZero(alpha)) {
         mCombinedAlpha = 0;
+        setDrawn(false);
         return;
     }
+    setDrawn(true);
 
     // 2. calculate the parent matrix and alpha
     VMatrix m = matrix(frameNo());
@@ -6439,6 +6495,7 @@ void LOTLayerItem::update(int frameNumber, const VMatrix &parentMatrix,
     if (mLayerMask) {
         mLayerMask->update(frameNo(), mCombinedMatrix, mCombinedAlpha,
                            mDirtyFlag);
+        if (!mLayerMask->isStatic()) mChanged = true;
     }
 
     // 5. if no parent property change and layer is static then nothing to do.
@@ -6446,8 +6503,11 @@ void LOTLayerItem::update(int frameNumber, const VMatrix &parentMatrix,
         isStatic())
         return;
 
+    if (!flag().testFlag(DirtyFlagBit::None)) mChanged = true;
+
     // 6. update the content of the layer
     updateContent();
+    mContentChanged = contentChanged();
 
     // 7. reset the dirty flag
     mDirtyFlag = DirtyFlagBit::None;
@@ -6528,6 +6588,7 @@ void LOTCompLayerItem::render(VPainter *painter, const VRle &inheritMask,
             renderHelper(&srcPainter, inheritMask, matteRle);
             srcPainter.end();
             painter->drawBitmap(VPoint(), srcBitmap, uchar(combinedAlpha() * 255.0f));
+            mBlendRect = painter->clipBoundingRect();
         } else {
             renderHelper(painter, inheritMask, matteRle);
         }
@@ -6571,6 +6632,31 @@ void LOTCompLayerItem::renderHelper(VPainter *painter, const VRle &inheritMask,
     }
 }
 
+void LOTCompLayerItem::damage(VRect &region, bool force)
+{
+    // alpha, mask or clip of composition change all its content
+    force = force || mChanged;
+
+    LOTLayerItem *matte = nullptr;
+    for (const auto &layer : mLayers) {
+        if (layer->hasMatte()) {
+            matte = layer;
+        } else {
+            if (matte) {
+                // matte and its source are drawn together
+                bool pairChanged = force || matte->changed() || layer->changed();
+                matte->damage(region, pairChanged);
+                layer->damage(region, pairChanged);
+            } else {
+                layer->damage(region, force);
+            }
+            matte = nullptr;
+        }
+    }
+    // composition draws nothing itself, only its bitmap when alpha is applied
+    LOTLayerItem::damage(region, force);
+}
+
 void LOTCompLayerItem::renderMatteLayer(VPainter *painter, const VRle &mask,
                                         const VRle &  matteRle,
                                         LOTLayerItem *layer, LOTLayerItem *src)
@@ -6619,6 +6705,7 @@ void LOTCompLayerItem::renderMatteLayer(VPainter *painter, const VRle &mask,
     layerPainter.end();
     // 3. draw the result buffer into painter
     painter->drawBitmap(VPoint(), layer->bitmap());
+    layer->setBlendRect(painter->clipBoundingRect());
 }
 
 void LOTClipperItem::update(const VMatrix &matrix)
@@ -6660,6 +6747,14 @@ void LOTCompLayerItem::updateContent()
     }
 }
 
+bool LOTCompLayerItem::contentChanged() const
+{
+    for (const auto &layer : mLayers) {
+        if (layer->changed()) return true;
+    }
+    return false;
+}
+
 void LOTCompLayerItem::preprocessStage(const VRect &clip)
 {
     // if layer has clipper
@@ -6850,6 +6945,11 @@ void LOTShapeLayerItem::updateContent()
     }
 }
 
+bool LOTShapeLayerItem::contentChanged() const
+{
+    return mRoot->changed();
+}
+
 void LOTShapeLayerItem::preprocessStage(const VRect& clip)
 {
     mDrawableList.clear();
@@ -6980,6 +7080,14 @@ void LOTContentGroupItem::update(int frameNo, const VMatrix &parentMatrix,
     }
 }
 
+bool LOTContentGroupItem::changed() const
+{
+    for (const auto &content : mContents) {
+        if (content->changed()) return true;
+    }
+    return false;
+}
+
 void LOTContentGroupItem::applyTrim()
 {
     for (auto i = mContents.rbegin(); i != mContents.rend(); ++i) {
@@ -7194,7 +7302,13 @@ void LOTPaintDataItem::update(int   frameNo, const VMatrix & parentMatrix,
                               float parentAlpha, const DirtyFlag &/*flag*/)
 {
     mRenderNodeUpdate = true;
-    mContentToRender = updateContent(frameNo, parentMatrix, parentAlpha);
+    bool contentToRender = updateContent(frameNo, parentMatrix, parentAlpha);
+
+    // static paint looks same until alpha or visibility changed
+    mChanged = !mStaticContent || !vCompare(mAlpha, parentAlpha) ||
+               (mContentToRender != contentToRender);
+    mAlpha = parentAlpha;
+    mContentToRender = contentToRender;
 }
 
 void LOTPaintDataItem::updateRenderNode()
@@ -7523,6 +7637,8 @@ LOTCApiData::LOTCApiData()
 void LOTCompItem::buildRenderTree()
 {
     mRootLayer->buildLayerNode();
+    // layers were updated without render, next render not know what changed
+    mFullDamage = true;
 }
 
 const LOTLayerNode *LOTCompItem::renderTree() const
@@ -7860,6 +7976,8 @@ public:
     size_t  totalFrame() const { return mModel->totalFrame(); }
     size_t  frameAtPos(double pos) const { return mModel->frameAtPos(pos); }
     Surface render(size_t frameNo, const Surface &surface, bool keepAspectRatio);
+    bool renderSync(size_t frameNo, const Surface &surface, bool keepAspectRatio, bool skipUnchanged);
+    const VRect &damage() const { return mCompItem->damage(); }
 
     const LOTLayerNode * renderTree(size_t frameNo, const VSize &size);
 
@@ -7912,20 +8030,27 @@ bool AnimationImpl::update(size_t frameNo, const VSize &size, bool keepAspectRat
 }
 
 Surface AnimationImpl::render(size_t frameNo, const Surface &surface, bool keepAspectRatio)
+{
+    renderSync(frameNo, surface, keepAspectRatio, false);
+    return surface;
+}
+
+bool AnimationImpl::renderSync(size_t frameNo, const Surface &surface, bool keepAspectRatio, bool skipUnchanged)
 {
     bool renderInProgress = mRenderInProgress.load();
     if (renderInProgress) {
         vCritical << "Already Rendering Scheduled for this Animation";
-        return surface;
+        return false;
     }
 
     mRenderInProgress.store(true);
-    update(frameNo,
+    bool changed = update(frameNo,
            VSize(int(surface.drawRegionWidth()), int(surface.drawRegionHeight())), keepAspectRatio);
-    mCompItem->render(surface);
+    // surface already has same content, caller not need it drawn again
+    if (changed || !skipUnchanged) mCompItem->render(surface);
     mRenderInProgress.store(false);
 
-    return surface;
+    return changed;
 }
 
 void AnimationImpl::init(const std::shared_ptr<LOTModel> &model)
@@ -8025,9 +8150,19 @@ const LOTLayerNode *Animation::renderTree(size_t frameNo, size_t width,
     return d->renderTree(frameNo, VSize(int(width), int(height)));
 }
 
-void Animation::renderSync(size_t frameNo, Surface surface, bool keepAspectRatio)
+bool Animation::renderSync(size_t frameNo, Surface surface, bool keepAspectRatio, bool skipUnchanged)
+{
+    return d->renderSync(frameNo, surface, keepAspectRatio, skipUnchanged);
+}
+
+void Animation::damage(size_t &x, size_t &y, size_t &width, size_t &height) const
 {
-    d->render(frameNo, surface, keepAspectRatio);
+    const VRect &rect = d->damage();
+
+    x = size_t(rect.x());
+    y = size_t(rect.y());
+    width = size_t(rect.width());
+    height = size_t(rect.height());
 }
 
 const LayerInfoList &Animation::layers() const
@@ -0,0 +1,299 @@
+// Headless test of ImLottie scheduler: synthetic animations rendered by render thread with
+// LottieMemoryBackend and stepped by LottieManualClock, pixels of atlas must be same on every
+// run and for every start of clock, and frames shown by widgets must be frames of clock time.
+// Quality governor is left with default setting.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+// Synthetic animation instead of rlottie: 30 frames per second, pixel has frame index and
+// position, so frame, size and scale of canvas all change digest
+namespace imlottie {
+class Animation {
+public:
+    std::string path;
+};
+
+static std::atomic<int> g_renders{0};
+
+std::shared_ptr<Animation> animationLoad(const char *path) {
+    std::shared_ptr<Animation> anim = std::make_shared<Animation>();
+    anim->path = path;
+    return anim;
+}
+
+uint16_t animationTotalFrame(const std::shared_ptr<Animation> &) {
+    return 30;
+}
+
+double animationDuration(const std::shared_ptr<Animation> &) {
+    return 1.0;
+}
+
+const std::vector<std::tuple<std::string, int, int>> &animationMarkers(const std::shared_ptr<Animation> &) {
+    static const std::vector<std::tuple<std::string, int, int>> markers{{"intro", 0, 9}, {"idle", 10, 19}};
+    return markers;
+}
+
+bool animationRenderSync(const std::shared_ptr<Animation> &, int nextFrameIndex, uint32_t *data, int width, int height, int row_pitch, bool, int *damage) {
+    if (damage) {
+        damage[0] = 0;
+        damage[1] = 0;
+        damage[2] = width;
+        damage[3] = height;
+    }
+
+    // slower than clock steps, with host time governor would see overloaded thread and
+    // reduce quality, with manual clock frames must not depend on it
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    for (int y = 0; y < height; ++y) {
+        uint32_t *row = data + y * (row_pitch / 4);
+        for (int x = 0; x < width; ++x) {
+            row[x] = 0xff000000u | ((uint32_t)nextFrameIndex << 16) | (uint32_t)(y << 8) | (uint32_t)x;
+        }
+    }
+    g_renders++;
+    return true;
+}
+}
+
+#include "imgui.h"
+#include "imlottie.h"
+
+static constexpr int STEPS = 120;
+
+// Digest only proves that runs are same, frames themselves are checked by tests below it
+static constexpr uint64_t EXPECTED_DIGEST = 0xd7b0bf8c08bb3b64ull;
+
+static uint64_t fnv(uint64_t hash, uint64_t value) {
+    return (hash ^ value) * 1099511628211ull;
+}
+
+static uint64_t mix(uint64_t value) {
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+}
+
+// Atlas placement depends on order of loaders, so pixels of all textures are hashed without
+// order, empty atlas space is skipped
+static uint64_t atlasDigest(const ImLottie::LottieMemoryBackend &backend) {
+    uint64_t sum = 0;
+    uint64_t count = 0;
+    for (const auto &texture : backend.textures) {
+        const uint32_t *pixels = (const uint32_t *)texture->pixels.data();
+        const size_t size = texture->pixels.size() / 4;
+        for (size_t i = 0; i < size; ++i) {
+            if (pixels[i]) {
+                sum += mix(pixels[i]);
+                count++;
+            }
+        }
+    }
+    return mix(sum ^ mix(count));
+}
+
+static bool run(uint64_t startMs, uint64_t &digest) {
+    ImLottie::LottieMemoryBackend *backend = new ImLottie::LottieMemoryBackend();
+    ImLottie::LottieManualClock *clock = new ImLottie::LottieManualClock();
+    clock->set(startMs);
+    ImLottie::init(2, backend, clock);
+    // baked animations only copy frames, without baking render thread is loaded every step
+    ImLottie::setBakeBudget(0);
+
+    ImLottie::LottieHandle handle = ImLottie::createHandle("handle.json", ImVec2(40, 40), true, 0);
+    digest = 1469598103934665603ull;
+    for (int step = 1; step <= STEPS; ++step) {
+        GImGui->FrameCount = step;
+        ImLottie::LottieAnimation("loop.json", ImVec2(32, 32), true, 0);
+        ImLottie::LottieAnimation("once.json", ImVec2(48, 48), false, 0);
+        ImLottie::LottieAnimation("focused.json", ImVec2(64, 64), true, 0, 2);
+        ImLottie::LottieAnimation(handle, ImVec2(40, 40));
+        ImLottie::sync();
+        ImLottie::waitIdle();
+
+        clock->advance(step % 3 == 0 ? 17 : 16);
+        ImLottie::waitIdle();
+        digest = fnv(digest, atlasDigest(*backend));
+    }
+
+    const ImLottie::LottieQualityState quality = ImLottie::qualityState();
+    ImLottie::destroyHandle(handle);
+    ImLottie::destroy();
+
+    if (quality.level != 0) {
+        printf("start %llu: quality level %d with manual clock\n", (unsigned long long)startMs, quality.level);
+        return false;
+    }
+    return true;
+}
+
+// synthetic animation has 30 frames in 1 second
+static constexpr int TOTAL_FRAMES = 30;
+static constexpr uint64_t FRAME_MS = 1000 / TOTAL_FRAMES;
+
+static int failures = 0;
+
+static void expect(bool ok, const char *what) {
+    if (!ok) {
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+static void expectFrame(int frame, int expected, const char *what) {
+    if (frame != expected) {
+        printf("FAIL: %s, frame %d expected %d\n", what, frame, expected);
+        failures++;
+    }
+}
+
+// one imgui frame: widgets drawn, ready frames uploaded and render thread finished all work
+// due at current clock time, so next frame uploads frames of this time
+template<typename Widgets>
+static void imguiFrame(Widgets widgets) {
+    GImGui->FrameCount++;
+    ImGui::GetCurrentWindow()->DrawList->lastTexture = nullptr;
+    widgets();
+    ImLottie::sync();
+    ImLottie::waitIdle();
+}
+
+// first frame sends widget to render thread, model loaded and frame rendered, second one uploads
+// it, only widgets of third frame draw texture
+template<typename Widgets>
+static void warmUp(Widgets widgets) {
+    imguiFrame(widgets);
+    imguiFrame(widgets);
+}
+
+static void advance(ImLottie::LottieManualClock *clock, uint64_t ms) {
+    clock->advance(ms);
+    ImLottie::waitIdle();
+}
+
+// frame index which synthetic renderer put to pixels of last drawn image, -1 when nothing drawn
+static int drawnFrame(ImLottie::LottieMemoryBackend *backend) {
+    const ImDrawList &drawList = *ImGui::GetCurrentWindow()->DrawList;
+    const ImLottie::LottieMemoryBackend::Texture *texture = backend->find(drawList.lastTexture);
+    if (!texture) {
+        return -1;
+    }
+
+    const int x = (int)((drawList.lastUv0.x + drawList.lastUv1.x) * 0.5f * texture->width);
+    const int y = (int)((drawList.lastUv0.y + drawList.lastUv1.y) * 0.5f * texture->height);
+    uint32_t pixel;
+    memcpy(&pixel, &texture->pixels[((size_t)y * texture->width + x) * 4], 4);
+    return (int)((pixel >> 16) & 0xff);
+}
+
+// looped handle shows frame of clock time, timeline starts when model loaded
+static void testClockFrames(uint64_t startMs) {
+    ImLottie::LottieMemoryBackend *backend = new ImLottie::LottieMemoryBackend();
+    ImLottie::LottieManualClock *clock = new ImLottie::LottieManualClock();
+    clock->set(startMs);
+    ImLottie::init(2, backend, clock);
+
+    ImLottie::LottieHandle handle = ImLottie::createHandle("clock.json", ImVec2(40, 40), true, 0);
+    auto widgets = [&] { ImLottie::LottieAnimation(handle, ImVec2(40, 40)); };
+    warmUp(widgets);
+    for (int step = 0; step < 100; ++step) {
+        advance(clock, 10);
+        imguiFrame(widgets);
+        const int expected = (int)((clock->nowMs() - startMs) / FRAME_MS % TOTAL_FRAMES);
+        expectFrame(drawnFrame(backend), expected, "frame of clock time");
+    }
+
+    ImLottie::destroyHandle(handle);
+    ImLottie::destroy();
+}
+
+// seek and segment show requested frame on next imgui frame and play from it
+static void testSeekAndSegment() {
+    ImLottie::LottieMemoryBackend *backend = new ImLottie::LottieMemoryBackend();
+    ImLottie::LottieManualClock *clock = new ImLottie::LottieManualClock();
+    ImLottie::init(2, backend, clock);
+
+    ImLottie::LottieHandle handle = ImLottie::createHandle("seek.json", ImVec2(40, 40), true, 0);
+    auto widgets = [&] { ImLottie::LottieAnimation(handle, ImVec2(40, 40)); };
+    warmUp(widgets);
+    advance(clock, 5 * FRAME_MS);
+    imguiFrame(widgets);
+    expectFrame(drawnFrame(backend), 5, "frame before seek");
+
+    ImLottie::seek(handle, 12);
+    imguiFrame(widgets);
+    imguiFrame(widgets);
+    expectFrame(drawnFrame(backend), 12, "seek");
+    advance(clock, 3 * FRAME_MS);
+    imguiFrame(widgets);
+    expectFrame(drawnFrame(backend), 15, "play after seek");
+
+    ImLottie::playSegment(handle, 20, 25, false);
+    imguiFrame(widgets);
+    imguiFrame(widgets);
+    expectFrame(drawnFrame(backend), 20, "segment start");
+    advance(clock, 2 * FRAME_MS);
+    imguiFrame(widgets);
+    expectFrame(drawnFrame(backend), 22, "segment play");
+    advance(clock, 20 * FRAME_MS);
+    imguiFrame(widgets);
+    expectFrame(drawnFrame(backend), 25, "segment stays on last frame");
+
+    ImLottie::destroyHandle(handle);
+    ImLottie::destroy();
+}
+
+// handle destroyed after its widget in same frame, draw data of frame still has its texture,
+// so atlas page must live until that frame rendered
+static void testDestroyDrawnHandle() {
+    ImLottie::LottieMemoryBackend *backend = new ImLottie::LottieMemoryBackend();
+    ImLottie::LottieManualClock *clock = new ImLottie::LottieManualClock();
+    ImLottie::init(2, backend, clock);
+
+    ImLottie::LottieHandle handle = ImLottie::createHandle("close.json", ImVec2(40, 40), true, 0);
+    warmUp([&] { ImLottie::LottieAnimation(handle, ImVec2(40, 40)); });
+    advance(clock, FRAME_MS);
+
+    void *drawn = nullptr;
+    imguiFrame([&] {
+        ImLottie::LottieAnimation(handle, ImVec2(40, 40));
+        drawn = ImGui::GetCurrentWindow()->DrawList->lastTexture;
+        ImLottie::destroyHandle(handle);
+    });
+    expect(drawn != nullptr, "handle drawn before destroy");
+    expect(backend->find(drawn) != nullptr, "texture drawn in frame alive after its sync");
+
+    imguiFrame([] {});
+    expect(backend->find(drawn) == nullptr, "texture of empty page destroyed on next frame");
+
+    ImLottie::destroy();
+}
+
+int main() {
+    const uint64_t starts[] = {0, 0, 0xFFFFFF00ull, 1ull << 40};
+    for (uint64_t start : starts) {
+        uint64_t digest = 0;
+        const bool ok = run(start, digest);
+        const bool same = digest == EXPECTED_DIGEST;
+        printf("start %llu digest %016llx %s\n", (unsigned long long)start, (unsigned long long)digest, ok && same ? "ok" : "FAIL");
+        failures += !(ok && same);
+    }
+
+    testClockFrames(0);
+    testClockFrames(1ull << 40);
+    testSeekAndSegment();
+    testDestroyDrawnHandle();
+
+    printf("renders %d, failures %d\n", imlottie::g_renders.load(), failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,114 @@
+// Minimal part of Dear ImGui api which imlottie.h uses, only for headless tests. Widgets
+// are laid out to nowhere, draw list keeps last image so test can see what was drawn.
+#pragma once
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <memory>
+
+typedef unsigned int ImGuiID;
+typedef unsigned int ImU32;
+typedef void *ImTextureID;
+typedef int ImGuiWindowFlags;
+typedef int ImGuiTableFlags;
+
+enum { ImGuiTableFlags_Borders = 1, ImGuiTableFlags_RowBg = 2, ImGuiTableFlags_ScrollY = 4, ImGuiTableFlags_Resizable = 8 };
+enum ImGuiCol_ { ImGuiCol_Text = 0, ImGuiCol_FrameBg = 7 };
+
+struct ImVec2 {
+    float x = 0, y = 0;
+    ImVec2() {}
+    ImVec2(float _x, float _y) : x(_x), y(_y) {}
+};
+
+struct ImVec4 {
+    float x = 0, y = 0, z = 0, w = 0;
+    ImVec4() {}
+    ImVec4(float _x, float _y, float _z, float _w) : x(_x), y(_y), z(_z), w(_w) {}
+};
+
+struct ImRect {
+    ImVec2 Min, Max;
+    ImRect(const ImVec2 &min, const ImVec2 &max) : Min(min), Max(max) {}
+    ImVec2 GetCenter() const { return ImVec2((Min.x + Max.x) * 0.5f, (Min.y + Max.y) * 0.5f); }
+    float GetWidth() const { return Max.x - Min.x; }
+    float GetHeight() const { return Max.y - Min.y; }
+};
+
+ImGuiID ImHashStr(const char *data, size_t data_size = 0, ImU32 seed = 0);
+ImGuiID ImHashData(const void *data, size_t data_size, ImU32 seed = 0);
+
+struct ImDrawList {
+    int images = 0;
+    // last drawn image, tests read its pixels from texture
+    ImTextureID lastTexture = nullptr;
+    ImVec2 lastUv0, lastUv1;
+
+    void AddImage(ImTextureID user_texture_id, const ImVec2 &p_min, const ImVec2 &p_max, const ImVec2 &uv_min = ImVec2(0, 0), const ImVec2 &uv_max = ImVec2(1, 1), ImU32 col = 0xffffffff);
+    void AddRectFilled(const ImVec2 &p_min, const ImVec2 &p_max, ImU32 col, float rounding = 0.f);
+    void AddRect(const ImVec2 &p_min, const ImVec2 &p_max, ImU32 col, float rounding = 0.f);
+};
+
+struct ImGuiWindowTempData {
+    ImVec2 CursorPos;
+};
+
+struct ImGuiWindow {
+    bool SkipItems = false;
+    ImGuiWindowTempData DC;
+    ImDrawList *DrawList = nullptr;
+
+    ImGuiID GetID(const char *str);
+    ImGuiID GetID(const void *ptr);
+    ImGuiID GetID(int n);
+};
+
+struct ImGuiStyle {
+    ImVec2 FramePadding;
+};
+
+struct ImGuiIO {
+    ImVec2 DisplayFramebufferScale = ImVec2(1, 1);
+    float DeltaTime = 1.f / 60.f;
+};
+
+struct ImGuiContext {
+    ImGuiStyle Style;
+    ImGuiIO IO;
+    int FrameCount = 0;
+    double Time = 0;
+};
+
+extern ImGuiContext *GImGui;
+
+namespace ImGui {
+ImGuiWindow *GetCurrentWindow();
+void ItemSize(const ImRect &bb, float text_baseline_y = -1.f);
+bool ItemAdd(const ImRect &bb, ImGuiID id, const ImRect *nav_bb = nullptr, int extra_flags = 0);
+ImU32 GetColorU32(const ImVec4 &col);
+ImU32 GetColorU32(int idx, float alpha_mul = 1.f);
+double GetTime();
+int GetFrameCount();
+ImGuiIO &GetIO();
+bool Begin(const char *name, bool *p_open = nullptr, ImGuiWindowFlags flags = 0);
+void End();
+void Text(const char *fmt, ...);
+void SameLine(float offset_from_start_x = 0.f, float spacing = -1.f);
+void Separator();
+bool IsItemHovered(int flags = 0);
+bool IsWindowFocused(int flags = 0);
+bool BeginTable(const char *str_id, int column, int flags = 0);
+void EndTable();
+void TableSetupColumn(const char *label, int flags = 0, float init_width_or_weight = 0.f);
+void TableHeadersRow();
+void TableNextRow(int row_flags = 0, float min_row_height = 0.f);
+bool TableNextColumn();
+void TableSetupScrollFreeze(int cols, int rows);
+void TextUnformatted(const char *text, const char *text_end = nullptr);
+void ProgressBar(float fraction, const ImVec2 &size_arg = ImVec2(-1, 0), const char *overlay = nullptr);
+bool CollapsingHeader(const char *label, int flags = 0);
+}
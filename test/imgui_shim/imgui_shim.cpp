@@ -0,0 +1,69 @@
+#include "imgui.h"
+
+static ImDrawList g_drawList;
+static ImGuiWindow g_window;
+static ImGuiContext g_context;
+ImGuiContext *GImGui = &g_context;
+
+ImGuiID ImHashStr(const char *data, size_t data_size, ImU32 seed) {
+    ImU32 hash = ~seed;
+    if (!data_size) {
+        data_size = strlen(data);
+    }
+    for (size_t i = 0; i < data_size; ++i) {
+        hash = (hash ^ (unsigned char)data[i]) * 16777619u;
+    }
+    return ~hash;
+}
+
+ImGuiID ImHashData(const void *data, size_t data_size, ImU32 seed) {
+    return ImHashStr((const char *)data, data_size ? data_size : 1, seed);
+}
+
+void ImDrawList::AddImage(ImTextureID user_texture_id, const ImVec2 &, const ImVec2 &, const ImVec2 &uv_min, const ImVec2 &uv_max, ImU32) {
+    if (user_texture_id) {
+        images++;
+        lastTexture = user_texture_id;
+        lastUv0 = uv_min;
+        lastUv1 = uv_max;
+    }
+}
+
+void ImDrawList::AddRectFilled(const ImVec2 &, const ImVec2 &, ImU32, float) {}
+void ImDrawList::AddRect(const ImVec2 &, const ImVec2 &, ImU32, float) {}
+
+ImGuiID ImGuiWindow::GetID(const char *str) { return ImHashStr(str); }
+ImGuiID ImGuiWindow::GetID(const void *ptr) { return ImHashData(&ptr, sizeof(ptr)); }
+ImGuiID ImGuiWindow::GetID(int n) { return ImHashData(&n, sizeof(n)); }
+
+namespace ImGui {
+ImGuiWindow *GetCurrentWindow() {
+    g_window.DrawList = &g_drawList;
+    return &g_window;
+}
+
+void ItemSize(const ImRect &, float) {}
+bool ItemAdd(const ImRect &, ImGuiID, const ImRect *, int) { return true; }
+ImU32 GetColorU32(const ImVec4 &) { return 0xffffffff; }
+ImU32 GetColorU32(int, float) { return 0x40404040; }
+double GetTime() { return g_context.Time; }
+int GetFrameCount() { return g_context.FrameCount; }
+ImGuiIO &GetIO() { return g_context.IO; }
+bool Begin(const char *, bool *, ImGuiWindowFlags) { return true; }
+void End() {}
+void Text(const char *, ...) {}
+void SameLine(float, float) {}
+void Separator() {}
+bool IsItemHovered(int) { return false; }
+bool IsWindowFocused(int) { return false; }
+bool BeginTable(const char *, int, int) { return true; }
+void EndTable() {}
+void TableSetupColumn(const char *, int, float) {}
+void TableHeadersRow() {}
+void TableNextRow(int, float) {}
+bool TableNextColumn() { return true; }
+void TableSetupScrollFreeze(int, int) {}
+void TextUnformatted(const char *, const char *) {}
+void ProgressBar(float, const ImVec2 &, const char *) {}
+bool CollapsingHeader(const char *, int) { return true; }
+}